@@ -0,0 +1,48 @@
+#ifndef BUFFER_STREAM_H
+#define BUFFER_STREAM_H
+
+#include <Arduino.h>
+
+// Transport over a caller-owned input buffer that only counts its output,
+// so it never touches the heap and heap use measured around a pass belongs
+// to the command layer alone. Input is released in pieces, as it would
+// trickle in over a serial link.
+class BufferStream : public Stream {
+  public:
+    BufferStream(const uint8_t* data, size_t size)
+      : data(data), size(size), position(0), limit(0), written(0) {}
+
+    // Makes up to n more input bytes readable; returns how many
+    size_t release(size_t n) {
+      size_t left = size - limit;
+      n = n < left ? n : left;
+      limit += n;
+      return n;
+    }
+    bool exhausted() { return limit == size; }
+
+    int available() override { return (int)(limit - position); }
+    int read() override { return position < limit ? data[position++] : -1; }
+    int peek() override { return position < limit ? data[position] : -1; }
+    size_t write(uint8_t) override {
+      written++;
+      return 1;
+    }
+    using Print::write;
+
+    // Output bytes since the last call
+    size_t takeWritten() {
+      size_t n = written;
+      written = 0;
+      return n;
+    }
+
+  private:
+    const uint8_t* data;
+    size_t size;
+    size_t position;
+    size_t limit;
+    size_t written;
+};
+
+#endif
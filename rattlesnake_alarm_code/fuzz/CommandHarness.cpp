@@ -0,0 +1,103 @@
+#include "CommandHarness.h"
+#include "SegmentFormat.h"
+
+CommandHarness* CommandHarness::current = nullptr;
+
+CommandHarness::CommandHarness(Stream& io)
+  : time(1000000),
+    display(13, 12),
+    timer(display),
+    commands(io, timer, fsm),
+    alarm_start{0} {
+  current = this;
+
+  fsm.setActions(STATE_IDLE, enterIdle, nullptr, nullptr);
+  fsm.setActions(STATE_EDITING, nullptr, exitEditing, tickEditing);
+  fsm.setActions(STATE_RUNNING, enterRunning, nullptr, tickRunning);
+  fsm.setActions(STATE_ALARMING, enterAlarming, nullptr, tickAlarming);
+
+  timer.setOnFinished([]() { current->fsm.dispatch(EVENT_FINISHED); });
+  commands.setMotorStatusCallback([]() { return false; });
+
+  commands.addCommand("PROGRAM_LOAD", "PROGRAM_LOAD <sec>:<A|D|S>[:<repeat>],...", [](const String& args, Print& out) {
+    out.println(current->program.load(args) ? "Program loaded" : "Invalid program");
+  });
+  commands.addCommand("PROGRAM_STATUS", "PROGRAM_STATUS", [](const String& args, Print& out) {
+    current->program.printStatus(out);
+  });
+  commands.addCommand("DISPLAY_RATE", "DISPLAY_RATE <ms>", [](const String& args, Print& out) {
+    out.println(current->timer.setHighResInterval(args.toInt()));
+  });
+
+  timer.reset();
+}
+
+CommandHarness::~CommandHarness() {
+  current = nullptr;
+}
+
+bool CommandHarness::pass() {
+  time.advanceMillis(PASS_TIME_MS);
+  timer.update();
+  bool handled = commands.update();
+  fsm.tick();
+  return handled;
+}
+
+const char* CommandHarness::checkInvariants() {
+  State state = fsm.getState();
+  if (state >= STATE_COUNT) {
+    return "state out of range";
+  }
+  if (timer.isRunning() != (state == STATE_RUNNING)) {
+    return "timer running outside RUNNING, or RUNNING without a countdown";
+  }
+  int remaining = timer.getRemainingTime();
+  if (remaining < 0 || remaining > (int)SegmentFormat::MAX_SECONDS) {
+    return "remaining time out of range";
+  }
+  int preset = timer.getDefaultSeconds();
+  if (preset < 0 || preset > (int)SegmentFormat::MAX_SECONDS) {
+    return "preset out of range";
+  }
+  if (timer.isRunning() && timer.getRemainingMillis() > (unsigned long)remaining * 1000) {
+    return "countdown ahead of its whole seconds";
+  }
+  return nullptr;
+}
+
+void CommandHarness::enterIdle() {
+  current->timer.reset();
+}
+
+void CommandHarness::tickEditing() {
+  if (current->time.now() - current->fsm.getLastEventTime() >= Duration::fromMillis(EDIT_TIMEOUT_MS)) {
+    current->fsm.dispatch(EVENT_EDIT_DONE);
+  }
+}
+
+void CommandHarness::exitEditing() {
+  current->timer.commitEdit();
+}
+
+void CommandHarness::enterRunning() {
+  if (!current->timer.isRunning()) {
+    current->timer.start();
+  }
+}
+
+void CommandHarness::tickRunning() {
+  if (!current->timer.isRunning()) {
+    current->fsm.dispatch(EVENT_STOP);
+  }
+}
+
+void CommandHarness::enterAlarming() {
+  current->alarm_start = current->time.now();
+}
+
+void CommandHarness::tickAlarming() {
+  if (current->time.now() - current->alarm_start >= Duration::fromMillis(ALARM_TIME_MS)) {
+    current->fsm.dispatch(EVENT_ALARM_DONE);
+  }
+}
@@ -0,0 +1,51 @@
+#ifndef COMMAND_HARNESS_H
+#define COMMAND_HARNESS_H
+
+#include <Arduino.h>
+#include "CountdownTimer.h"
+#include "MirroredDisplay.h"
+#include "SerialCommands.h"
+#include "StateMachine.h"
+#include "TimerProgram.h"
+#include "ManualTime.h"
+
+// The command layer as main.cpp wires it, minus the hardware: a countdown
+// on a fake display, the state machine with the timer-facing actions, and
+// a few of the extra commands. Commands arrive on the given transport and
+// simulated time advances by PASS_TIME_MS per pass.
+class CommandHarness {
+  public:
+    CommandHarness(Stream& io);
+    ~CommandHarness();
+
+    // One loop() pass: timer, commands, state machine; true if a command
+    // was handled
+    bool pass();
+    // nullptr if the timer and state machine agree, otherwise what is wrong
+    const char* checkInvariants();
+
+    ManualTime time;
+    MirroredDisplay display;
+    CountdownTimer timer;
+    StateMachine fsm;
+    TimerProgram program;
+    SerialCommands commands;
+
+    static const int64_t PASS_TIME_MS = 250;
+    static const int64_t ALARM_TIME_MS = 3000;
+    static const int64_t EDIT_TIMEOUT_MS = 3000;
+
+  private:
+    Instant alarm_start;
+
+    static CommandHarness* current;
+    static void enterIdle();
+    static void tickEditing();
+    static void exitEditing();
+    static void enterRunning();
+    static void tickRunning();
+    static void enterAlarming();
+    static void tickAlarming();
+};
+
+#endif
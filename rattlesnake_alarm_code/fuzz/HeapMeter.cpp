@@ -0,0 +1,84 @@
+#include "HeapMeter.h"
+#include <stdlib.h>
+#include <new>
+
+size_t HeapMeter::live = 0;
+size_t HeapMeter::high_water = 0;
+
+HeapMeter::Scope::Scope() : base(live), outer_peak(high_water) {
+  high_water = live;
+}
+
+HeapMeter::Scope::~Scope() {
+  if (outer_peak > high_water) {
+    high_water = outer_peak;
+  }
+}
+
+long HeapMeter::Scope::retained() {
+  return (long)live - (long)base;
+}
+
+size_t HeapMeter::Scope::peak() {
+  return high_water - base;
+}
+
+// Each block carries its size in a header so delete can count it
+static const size_t HEADER = alignof(max_align_t);
+
+static void* allocate(size_t size) {
+  unsigned char* block = (unsigned char*)malloc(size + HEADER);
+  if (!block) {
+    return nullptr;
+  }
+  *(size_t*)block = size;
+  HeapMeter::live += size;
+  if (HeapMeter::live > HeapMeter::high_water) {
+    HeapMeter::high_water = HeapMeter::live;
+  }
+  return block + HEADER;
+}
+
+static void release(void* p) {
+  if (p) {
+    unsigned char* block = (unsigned char*)p - HEADER;
+    HeapMeter::live -= *(size_t*)block;
+    free(block);
+  }
+}
+
+void* operator new(size_t size) {
+  void* p = allocate(size);
+  if (!p) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void* operator new[](size_t size) {
+  return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+  return allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+  return allocate(size);
+}
+
+void operator delete(void* p) noexcept {
+  release(p);
+}
+
+void operator delete[](void* p) noexcept {
+  release(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+  release(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+  release(p);
+}
@@ -0,0 +1,28 @@
+#ifndef HEAP_METER_H
+#define HEAP_METER_H
+
+#include <stddef.h>
+
+// Counts heap bytes through replaced global operator new/delete (see
+// HeapMeter.cpp). A Scope reports what was allocated since it was opened.
+class HeapMeter {
+  public:
+    class Scope {
+      public:
+        Scope();
+        ~Scope();
+        // Bytes allocated in the scope and not yet freed
+        long retained();
+        // Most bytes live at once, above where the scope started
+        size_t peak();
+
+      private:
+        size_t base;
+        size_t outer_peak;
+    };
+
+    static size_t live;
+    static size_t high_water;
+};
+
+#endif
@@ -0,0 +1,54 @@
+// Stand-in for libFuzzer's main() where the compiler has no -fsanitize=fuzzer
+// (e.g. GCC): runs every file given, or every file in a directory given,
+// through the target once. Enough to replay a corpus or a crash input.
+// Options meant for libFuzzer (-runs=0 etc.) are ignored.
+
+#include <dirent.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+static bool runFile(const std::string& path) {
+  FILE* file = fopen(path.c_str(), "rb");
+  if (!file) {
+    return false;
+  }
+  std::vector<uint8_t> data;
+  uint8_t buffer[4096];
+  size_t n;
+  while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+    data.insert(data.end(), buffer, buffer + n);
+  }
+  fclose(file);
+  LLVMFuzzerTestOneInput(data.data(), data.size());
+  return true;
+}
+
+int main(int argc, char** argv) {
+  int inputs = 0;
+  for (int i = 1; i < argc; i++) {
+    if (argv[i][0] == '-') {
+      continue;
+    }
+    DIR* dir = opendir(argv[i]);
+    if (!dir) {
+      if (!runFile(argv[i])) {
+        fprintf(stderr, "cannot read %s\n", argv[i]);
+        return 1;
+      }
+      inputs++;
+      continue;
+    }
+    while (dirent* entry = readdir(dir)) {
+      if (entry->d_name[0] != '.' && runFile(std::string(argv[i]) + "/" + entry->d_name)) {
+        inputs++;
+      }
+    }
+    closedir(dir);
+  }
+  printf("%d inputs ran clean\n", inputs);
+  return 0;
+}
@@ -0,0 +1,52 @@
+// libFuzzer target for the command layer: arbitrary bytes arrive on the
+// transport a piece at a time, with one loop() pass per piece. Besides the
+// sanitizers' crash and UB detection it checks that after every pass
+//  - the timer and state machine are consistent
+//  - the pass kept no heap memory and never held more than MAX_PASS_HEAP
+//  - the pass wrote at most MAX_PASS_OUTPUT bytes back
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "BufferStream.h"
+#include "CommandHarness.h"
+#include "HeapMeter.h"
+
+static const size_t MAX_PASS_HEAP = 2048;
+static const size_t MAX_PASS_OUTPUT = 4096;
+// Odd-sized pieces, so lines also get split across reads
+static const size_t CHUNK = 61;
+// Passes after the input ends, enough for buffered lines and timeouts
+static const int DRAIN_PASSES = 32;
+
+static void fail(const char* what) {
+  fprintf(stderr, "invariant violated: %s\n", what);
+  abort();
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  BufferStream io(data, size);
+  CommandHarness harness(io);
+
+  for (int drain = 0; drain < DRAIN_PASSES; ) {
+    if (io.release(CHUNK) == 0) {
+      drain++;
+    }
+
+    HeapMeter::Scope heap;
+    harness.pass();
+    if (heap.retained() != 0) {
+      fail("a pass kept heap memory");
+    }
+    if (heap.peak() > MAX_PASS_HEAP) {
+      fail("a pass used too much heap");
+    }
+    if (io.takeWritten() > MAX_PASS_OUTPUT) {
+      fail("a pass wrote too much output");
+    }
+    const char* broken = harness.checkInvariants();
+    if (broken) {
+      fail(broken);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,125 @@
+// Throughput mode: replays a command corpus as one flood on the transport
+// and times every loop() pass that handled a command.
+//
+//   serial_commands_replay [-n commands] <corpus file or directory>...
+//
+// Lines from the corpus are repeated until -n commands (default 100000)
+// are queued; all of it is readable from the start, as if the host wrote it
+// in one go. Reports commands per second and the per-command latency.
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "BufferStream.h"
+#include "CommandHarness.h"
+
+static bool readLines(const std::string& path, std::vector<std::string>& lines) {
+  FILE* file = fopen(path.c_str(), "rb");
+  if (!file) {
+    return false;
+  }
+  std::string line;
+  int c;
+  while ((c = fgetc(file)) != EOF) {
+    if (c == '\n') {
+      if (!line.empty()) {
+        lines.push_back(line);
+      }
+      line.clear();
+    } else {
+      line += (char)c;
+    }
+  }
+  if (!line.empty()) {
+    lines.push_back(line);
+  }
+  fclose(file);
+  return true;
+}
+
+static bool readCorpus(const char* path, std::vector<std::string>& lines) {
+  DIR* dir = opendir(path);
+  if (!dir) {
+    return readLines(path, lines);
+  }
+  std::vector<std::string> names;
+  while (dirent* entry = readdir(dir)) {
+    if (entry->d_name[0] != '.') {
+      names.push_back(entry->d_name);
+    }
+  }
+  closedir(dir);
+  std::sort(names.begin(), names.end());
+  for (const std::string& name : names) {
+    if (!readLines(std::string(path) + "/" + name, lines)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+int main(int argc, char** argv) {
+  long target = 100000;
+  std::vector<std::string> lines;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+      target = atol(argv[++i]);
+    } else if (!readCorpus(argv[i], lines)) {
+      fprintf(stderr, "cannot read %s\n", argv[i]);
+      return 1;
+    }
+  }
+  if (lines.empty() || target <= 0) {
+    fprintf(stderr, "usage: %s [-n commands] <corpus file or directory>...\n", argv[0]);
+    return 1;
+  }
+
+  std::string flood;
+  for (long i = 0; i < target; i++) {
+    flood += lines[i % lines.size()];
+    flood += '\n';
+  }
+
+  BufferStream io((const uint8_t*)flood.data(), flood.size());
+  io.release(flood.size());
+  CommandHarness harness(io);
+
+  typedef std::chrono::steady_clock Clock;
+  std::vector<double> latencies;
+  latencies.reserve(target);
+  size_t output = 0;
+  Clock::time_point start = Clock::now();
+  while (io.available() > 0) {
+    Clock::time_point before = Clock::now();
+    bool handled = harness.pass();
+    Clock::time_point after = Clock::now();
+    if (handled) {
+      latencies.push_back(std::chrono::duration<double, std::micro>(after - before).count());
+    }
+    output += io.takeWritten();
+    const char* broken = harness.checkInvariants();
+    if (broken) {
+      fprintf(stderr, "invariant violated: %s\n", broken);
+      return 1;
+    }
+  }
+  double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+  std::sort(latencies.begin(), latencies.end());
+  size_t n = latencies.size();
+  if (n == 0) {
+    fprintf(stderr, "no command in the corpus was accepted\n");
+    return 1;
+  }
+  printf("Commands: %zu from %zu corpus lines, %zu bytes in, %zu bytes out\n",
+         n, lines.size(), flood.size(), output);
+  printf("Throughput: %.0f commands/s\n", n / seconds);
+  printf("Latency per command (us): median %.2f  p99 %.2f  worst %.2f\n",
+         latencies[n / 2], latencies[n * 99 / 100], latencies[n - 1]);
+  return 0;
+}
@@ -0,0 +1,89 @@
+# Flash and RAM footprint per module, from the symbol table of the firmware ELF.
+#
+#   pio run -t size_report
+#
+# Prints a table and writes size_report.csv next to the ELF so the numbers
+# can be compared between builds.
+
+import csv
+import os
+import subprocess
+
+Import("env")
+
+# nm symbol types: code and read-only data live in flash, initialised data
+# takes flash (load image) and RAM, zero-initialised data only RAM
+FLASH_TYPES = set("tTrRwWvV")
+DATA_TYPES = set("dD")
+BSS_TYPES = set("bBcC")
+
+
+def module_for(location):
+    if not location:
+        return "(no line info)"
+    path = location.rsplit(":", 1)[0].replace("\\", "/")
+    project_src = env.subst("$PROJECT_SRC_DIR").replace("\\", "/")
+    if path.startswith(project_src):
+        return os.path.basename(path)
+    if "/libdeps/" in path:
+        return "lib: " + path.split("/libdeps/", 1)[1].split("/")[1]
+    if "libstdc++" in path or "/gcc/" in path or "newlib" in path:
+        return "toolchain runtime"
+    if "mbed" in path:
+        return "mbed-os"
+    if "/cores/" in path or "/variants/" in path or "/libraries/" in path:
+        return "arduino core"
+    return "other"
+
+
+def size_report(source, target, env):
+    elf = env.subst("$BUILD_DIR/${PROGNAME}.elf")
+    nm = env.subst("$CC")
+    nm = nm[:-len("gcc")] + "nm" if nm.endswith("gcc") else "arm-none-eabi-nm"
+
+    output = subprocess.check_output([nm, "-S", "-l", "--size-sort", elf], universal_newlines=True)
+
+    modules = {}
+    for line in output.splitlines():
+        location = ""
+        if "\t" in line:
+            line, location = line.split("\t", 1)
+        fields = line.split()
+        if len(fields) < 4:
+            continue
+        size = int(fields[1], 16)
+        kind = fields[2]
+        entry = modules.setdefault(module_for(location), [0, 0])
+        if kind in FLASH_TYPES:
+            entry[0] += size
+        elif kind in DATA_TYPES:
+            entry[0] += size
+            entry[1] += size
+        elif kind in BSS_TYPES:
+            entry[1] += size
+
+    rows = sorted(modules.items(), key=lambda item: item[1][0], reverse=True)
+    total_flash = sum(flash for _, (flash, _) in rows)
+    total_ram = sum(ram for _, (_, ram) in rows)
+
+    print("%-28s %10s %10s" % ("Module", "Flash", "RAM"))
+    for name, (flash, ram) in rows:
+        print("%-28s %10d %10d" % (name, flash, ram))
+    print("%-28s %10d %10d" % ("Total", total_flash, total_ram))
+
+    report = os.path.join(os.path.dirname(elf), "size_report.csv")
+    with open(report, "w") as f:
+        writer = csv.writer(f)
+        writer.writerow(["module", "flash", "ram"])
+        for name, (flash, ram) in rows:
+            writer.writerow([name, flash, ram])
+    print("Written to " + report)
+
+
+env.AddCustomTarget(
+    name="size_report",
+    dependencies="$BUILD_DIR/${PROGNAME}.elf",
+    actions=[size_report],
+    title="Size Report",
+    description="Flash and RAM usage per module from ELF symbol sizes",
+)
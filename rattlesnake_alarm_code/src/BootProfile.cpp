@@ -0,0 +1,28 @@
+#include "BootProfile.h"
+
+BootProfile::BootProfile()
+  : stages{},
+    times{},
+    count(0) {}
+
+void BootProfile::mark(const char* stage) {
+  if (count < MAX_STAGES) {
+    times[count] = Timebase::now();
+    stages[count] = stage;
+    count++;
+  }
+}
+
+void BootProfile::printTimeline(Print& out) {
+  out.println("Boot timeline (us since reset):");
+  Instant previous{0};
+  for (int i = 0; i < count; i++) {
+    out.print("  ");
+    out.print((unsigned long)times[i].us);
+    out.print(" (+");
+    out.print((unsigned long)(times[i] - previous).us);
+    out.print(") ");
+    out.println(stages[i]);
+    previous = times[i];
+  }
+}
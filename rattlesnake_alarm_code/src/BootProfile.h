@@ -0,0 +1,27 @@
+#ifndef BOOT_PROFILE_H
+#define BOOT_PROFILE_H
+
+#include <Arduino.h>
+#include "Timebase.h"
+
+// Timeline of named boot stages. Each mark() is a timestamp and a pointer
+// store, so marks can sit anywhere in setup() without skewing it. The
+// timebase starts at reset, so the first mark also shows how long the core
+// took to reach setup().
+class BootProfile {
+  public:
+    BootProfile();
+
+    // Stage names must be string literals; marks past MAX_STAGES are dropped
+    void mark(const char* stage);
+    void printTimeline(Print& out);
+
+    static const int MAX_STAGES = 16;
+
+  private:
+    const char* stages[MAX_STAGES];
+    Instant times[MAX_STAGES];
+    int count;
+};
+
+#endif
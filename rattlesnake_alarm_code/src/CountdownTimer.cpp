@@ -1,59 +1,136 @@
 #include "CountdownTimer.h"
+#include "SegmentFormat.h"
+#include "WallClock.h"
 
-CountdownTimer::CountdownTimer(TM1637Display& display) 
+CountdownTimer::CountdownTimer(MirroredDisplay& display) 
   : display(display), 
     default_seconds(10), 
     current_seconds(10), 
+    pending_seconds(10),
+    edit_pending(false),
+    edit_render_due(false),
+    last_edit_render{0},
     is_running(false),
-    last_update_time(0),
-    onFinished([]() {}),
+    deadline{Instant{0}},
+    last_update_time{0},
+    high_res_interval(50),
+    drift_ppb(0),
+    last_frame{0, 0, 0, 0},
+    frame_valid(false),
     current_blink_mode(BLINK_NONE),
-    blink_start_time(0),
-    last_blink_toggle(0),
+    blink_start_time{0},
+    last_blink_toggle{0},
     blink_state(true) {}
 
 void CountdownTimer::start() {
+  commitEdit();
+  startAt(Timebase::now());
+}
+
+void CountdownTimer::startAt(Instant at) {
   if (current_seconds > 0) {
-    is_running = true;
-    last_update_time = millis();
+    Duration duration = Duration::fromSeconds(current_seconds);
+    last_update_time = at;
+    // Split so the longest preset at the largest drift stays within 64 bits
+    deadline = Deadline::after(at, duration + Duration::fromMicros(duration.us / 1000 * drift_ppb / 1000000));
     current_blink_mode = BLINK_NONE; // Stop blinking when timer starts
+    frame_valid = false;
+    is_running = true;
   }
 }
 
-void CountdownTimer::reset() {
+// Continues a countdown that was interrupted, e.g. by a reset
+void CountdownTimer::resume(unsigned long remaining_ms) {
+  if (remaining_ms > 0) {
+    is_running = true;
+    current_seconds = SegmentFormat::ceilSeconds(remaining_ms);
+    last_update_time = Timebase::now();
+    deadline = Deadline::after(last_update_time, Duration::fromMillis(remaining_ms));
+    current_blink_mode = BLINK_NONE;
+    frame_valid = false;
+    showTimePrivate(current_seconds);
+  }
+}
+
+void CountdownTimer::reset(bool redraw) {
+  commitEdit();
   current_seconds = default_seconds;
   is_running = false;
   current_blink_mode = BLINK_NONE; // Stop blinking when reset
-  showTimePrivate(current_seconds);
+  frame_valid = false; // Someone else may have drawn on the display
+  if (redraw) {
+    showTimePrivate(current_seconds);
+  }
 }
 
 void CountdownTimer::incrementTime(int sec) {
   if (!is_running) {
-    default_seconds = max(0, default_seconds + sec);
-    current_seconds = default_seconds;
-    showTimePrivate(current_seconds);
+    // Held at what the display can show, so the preset never wraps
+    int seconds = getDefaultSeconds() + sec;
+    if (seconds < 0) {
+      seconds = 0;
+    } else if (seconds > (int)SegmentFormat::MAX_SECONDS) {
+      seconds = SegmentFormat::MAX_SECONDS;
+    }
+    pending_seconds = seconds;
+    edit_pending = true;
+    edit_render_due = true;
   }
 }
 
-void CountdownTimer::setOnFinished(std::function<void()> callback) {
+void CountdownTimer::commitEdit() {
+  if (edit_pending) {
+    default_seconds = pending_seconds;
+    current_seconds = pending_seconds;
+    edit_pending = false;
+    if (edit_render_due) {
+      edit_render_due = false;
+      showTimePrivate(current_seconds);
+    }
+  }
+}
+
+bool CountdownTimer::hasPendingEdit() {
+  return edit_pending;
+}
+
+void CountdownTimer::setOnFinished(Delegate<void()> callback) {
   onFinished = callback;
 }
 
 void CountdownTimer::update() {
   if (is_running) {
-    unsigned long now = millis();
-    if (now - last_update_time >= 1000) {
-      last_update_time = now;
+    Instant now = Timebase::now();
+    unsigned long remaining = deadline.remaining(now).toMillis();
 
-      if (current_seconds > 0) {
-        current_seconds--;
+    if (deadline.expired(now)) {
+      current_seconds = 0;
+      showHundredths(0);
+      is_running = false;
+      onFinished();
+    } else if (remaining < HIGH_RES_THRESHOLD) {
+      current_seconds = SegmentFormat::ceilSeconds(remaining);
+      if (now - last_update_time >= Duration::fromMillis(high_res_interval)) {
+        last_update_time = now;
+        showHundredths(remaining);
+      }
+    } else {
+      // Whole seconds round up, so a 10s countdown starts on 00:10
+      int seconds = SegmentFormat::ceilSeconds(remaining);
+      if (seconds != current_seconds) {
+        current_seconds = seconds;
+        last_update_time = now;
         showTimePrivate(current_seconds);
-      } else {
-        is_running = false;
-        onFinished();
       }
     }
   } else {
+    // However many detents came in since, one frame shows the latest value
+    Instant now = Timebase::now();
+    if (edit_render_due && now - last_edit_render >= Duration::fromMillis(EDIT_RENDER_INTERVAL)) {
+      edit_render_due = false;
+      last_edit_render = now;
+      showTimePrivate(pending_seconds);
+    }
     // Update blinking when not running
     updateBlinking();
   }
@@ -61,6 +138,8 @@ void CountdownTimer::update() {
 
 void CountdownTimer::setTime(int seconds) {
   if (!is_running) {
+    edit_pending = false;
+    edit_render_due = false;
     default_seconds = seconds;
     current_seconds = seconds;
     current_blink_mode = BLINK_NONE; // Stop blinking when time is set via command
@@ -69,14 +148,14 @@ void CountdownTimer::setTime(int seconds) {
 }
 
 void CountdownTimer::setLastUpdateTime() {
-  last_update_time = millis();
+  last_update_time = Timebase::now();
 }
 
 void CountdownTimer::triggerBlink(BlinkMode mode) {
   if (!is_running) {
     current_blink_mode = mode;
-    blink_start_time = millis();
-    last_blink_toggle = millis();
+    blink_start_time = Timebase::now();
+    last_blink_toggle = blink_start_time;
     blink_state = true;
   }
 }
@@ -86,7 +165,41 @@ bool CountdownTimer::isRunning() {
 }
 
 int CountdownTimer::getRemainingTime() {
-  return current_seconds;
+  return edit_pending ? pending_seconds : current_seconds;
+}
+
+int CountdownTimer::getDefaultSeconds() {
+  return edit_pending ? pending_seconds : default_seconds;
+}
+
+unsigned long CountdownTimer::getRemainingMillis() {
+  if (!is_running) {
+    return getRemainingTime() * 1000UL;
+  }
+  return deadline.remaining(Timebase::now()).toMillis();
+}
+
+unsigned long CountdownTimer::setHighResInterval(unsigned long ms) {
+  if (ms < MIN_HIGH_RES_INTERVAL) {
+    ms = MIN_HIGH_RES_INTERVAL;
+  } else if (ms > MAX_HIGH_RES_INTERVAL) {
+    ms = MAX_HIGH_RES_INTERVAL; // also catches a negative argument
+  }
+  high_res_interval = ms;
+  return high_res_interval;
+}
+
+unsigned long CountdownTimer::getHighResInterval() {
+  return high_res_interval;
+}
+
+void CountdownTimer::setDriftCorrection(int32_t ppb) {
+  if (ppb > WallClock::MAX_DRIFT_PPB) {
+    ppb = WallClock::MAX_DRIFT_PPB;
+  } else if (ppb < -WallClock::MAX_DRIFT_PPB) {
+    ppb = -WallClock::MAX_DRIFT_PPB;
+  }
+  drift_ppb = ppb;
 }
 
 void CountdownTimer::showTime(int seconds) {
@@ -97,96 +210,85 @@ void CountdownTimer::showTimePrivate(int seconds) {
   if (current_blink_mode != BLINK_NONE && !is_running) {
     showTimeWithBlink(seconds);
   } else {
-    int minutes = seconds / 60;
-    int secs = seconds % 60;
-    int display_value = minutes * 100 + secs;
-    display.showNumberDecEx(display_value, 0b11100000, true);
+    uint8_t segments[4];
+    SegmentFormat::clock(seconds, segments);
+    writeFrame(segments);
+  }
+}
+
+// The colon doubles as the decimal separator
+void CountdownTimer::showHundredths(unsigned long remaining_ms) {
+  uint8_t segments[4];
+  SegmentFormat::hundredths(remaining_ms, segments);
+  writeFrame(segments);
+}
+
+// Sends only the run of digits that differ from the last frame; in ss.cc
+// mode that is usually just the hundredths
+void CountdownTimer::writeFrame(const uint8_t segments[4]) {
+  int first = 0;
+  int last = 3;
+  if (frame_valid) {
+    while (first <= last && segments[first] == last_frame[first]) {
+      first++;
+    }
+    while (last >= first && segments[last] == last_frame[last]) {
+      last--;
+    }
+    if (first > last) {
+      return;
+    }
   }
+
+  display.setSegments(&segments[first], last - first + 1, first);
+  memcpy(last_frame, segments, sizeof(last_frame));
+  frame_valid = true;
 }
 
 void CountdownTimer::updateBlinking() {
-  unsigned long now = millis();
+  Instant now = Timebase::now();
   
   // Check if blink timeout has elapsed
-  if (current_blink_mode != BLINK_NONE && (now - blink_start_time >= BLINK_TIMEOUT)) {
+  if (current_blink_mode != BLINK_NONE && (now - blink_start_time >= Duration::fromMillis(BLINK_TIMEOUT))) {
     current_blink_mode = BLINK_NONE;
-    showTimePrivate(current_seconds); // Show solid display
+    showTimePrivate(getRemainingTime()); // Show solid display
     return;
   }
   
   // Handle blink timing
   if (current_blink_mode != BLINK_NONE) {
-    unsigned long time_in_cycle = (now - last_blink_toggle);
+    unsigned long time_in_cycle = (now - last_blink_toggle).toMillis();
     
     if (blink_state && time_in_cycle >= BLINK_ON_TIME) {
       // Switch to off state
       blink_state = false;
       last_blink_toggle = now;
-      showTimeWithBlink(current_seconds);
+      showTimeWithBlink(getRemainingTime());
     } else if (!blink_state && time_in_cycle >= BLINK_OFF_TIME) {
       // Switch to on state
       blink_state = true;
       last_blink_toggle = now;
-      showTimeWithBlink(current_seconds);
+      showTimeWithBlink(getRemainingTime());
     }
   }
 }
 
 void CountdownTimer::showTimeWithBlink(int seconds) {
-  int minutes = seconds / 60;
-  int secs = seconds % 60;
-  
   uint8_t segments[4];
-  
-  // Get individual digits
-  segments[0] = getDigit(minutes, 1);  // Minutes tens
-  segments[1] = getDigit(minutes, 0);  // Minutes ones
-  segments[2] = getDigit(secs, 1);     // Seconds tens
-  segments[3] = getDigit(secs, 0);     // Seconds ones
+  SegmentFormat::clock(seconds, segments);
   
   // Apply blinking logic
   if (!blink_state) {
     if (current_blink_mode == BLINK_MINUTES) {
       segments[0] = 0x00; // Turn off minutes tens
-      segments[1] = 0x00; // Turn off minutes ones
+      segments[1] &= 0x80; // Turn off minutes ones, keep the colon
     } else if (current_blink_mode == BLINK_SECONDS) {
       segments[2] = 0x00; // Turn off seconds tens
       segments[3] = 0x00; // Turn off seconds ones
     }
   }
   
-  // Always show colon
-  display.setSegments(segments, 4, 0);
-  display.showNumberDecEx(0, 0b11100000, false); // Just to set the colon
-  
-  // Set segments manually to preserve colon
-  for (int i = 0; i < 4; i++) {
-    display.setSegments(&segments[i], 1, i);
-  }
-}
+  frame_valid = false;
 
-uint8_t CountdownTimer::getDigit(int value, int position) {
-  // Position 0 = ones digit, position 1 = tens digit
-  int digit;
-  if (position == 0) {
-    digit = value % 10;
-  } else {
-    digit = (value / 10) % 10;
-  }
-  
-  // 7-segment encoding for digits 0-9
-  const uint8_t digitToSegment[] = {
-    0x3f, // 0
-    0x06, // 1
-    0x5b, // 2
-    0x4f, // 3
-    0x66, // 4
-    0x6d, // 5
-    0x7d, // 6
-    0x07, // 7
-    0x7f, // 8
-    0x6f  // 9
-  };
-  
-  return digitToSegment[digit];
+  display.setSegments(segments, 4, 0);
 }
\ No newline at end of file
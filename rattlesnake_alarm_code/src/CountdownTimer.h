@@ -2,19 +2,31 @@
 #define COUNTDOWN_TIMER_H
 
 #include <Arduino.h>
-#include <TM1637Display.h>
-#include <functional>
+#include "MirroredDisplay.h"
+#include "Delegate.h"
+#include "Timebase.h"
 
 enum BlinkMode { BLINK_NONE, BLINK_MINUTES, BLINK_SECONDS };
 
 class CountdownTimer {
   public:
-    CountdownTimer(TM1637Display& display);
+    CountdownTimer(MirroredDisplay& display);
     
     void start();
-    void reset();
+    // start() from a given instant, e.g. a sync edge; no display traffic,
+    // so it may be called from an interrupt while idle
+    void startAt(Instant at);
+    void resume(unsigned long remaining_ms);
+    // Without redraw the display keeps what another owner drew (e.g. a
+    // stopwatch reading) until the next showTime
+    void reset(bool redraw = true);
+    // Encoder edits go to a pending value that getters report at once; the
+    // display catches up at most once per EDIT_RENDER_INTERVAL and the
+    // preset only changes on commitEdit() (also done by start and reset)
     void incrementTime(int sec);
-    void setOnFinished(std::function<void()> callback);
+    void commitEdit();
+    bool hasPendingEdit();
+    void setOnFinished(Delegate<void()> callback);
     void update();
     void setTime(int seconds);
     void setLastUpdateTime();
@@ -22,30 +34,61 @@ class CountdownTimer {
     
     bool isRunning();
     int getRemainingTime();
+    int getDefaultSeconds();
+    unsigned long getRemainingMillis();
     void showTime(int seconds);
 
+    // Below HIGH_RES_THRESHOLD the display switches from mm:ss to ss.cc and
+    // is refreshed every interval instead of once per second
+    unsigned long setHighResInterval(unsigned long ms);
+    unsigned long getHighResInterval();
+
+    // Rate error of the local clock in parts per billion (> 0 = runs fast),
+    // applied to every countdown started afterwards; held to what
+    // WallClock accepts
+    void setDriftCorrection(int32_t ppb);
+
+    // One 4-digit frame is ~7 bytes on the bus, about 1ms at the 5us bit
+    // delay main.cpp uses; the hundredths digit changes no faster than this
+    static const unsigned long MIN_HIGH_RES_INTERVAL = 10;
+    // Slower than this the hundredths would hardly ever change
+    static const unsigned long MAX_HIGH_RES_INTERVAL = 1000;
+    static const unsigned long EDIT_RENDER_INTERVAL = 50;
+    // ss.cc only has two digits of seconds
+    static const unsigned long HIGH_RES_THRESHOLD = 60000;
+
   private:
-    TM1637Display& display;
+    MirroredDisplay& display;
     int default_seconds;
     int current_seconds;
+    int pending_seconds;
+    bool edit_pending;
+    bool edit_render_due;
+    Instant last_edit_render;
     bool is_running;
-    unsigned long last_update_time;
-    std::function<void()> onFinished;
+    Deadline deadline;
+    Instant last_update_time;
+    unsigned long high_res_interval;
+    int32_t drift_ppb;
+    uint8_t last_frame[4];
+    bool frame_valid;
+    Delegate<void()> onFinished;
     
     // Blinking functionality
     BlinkMode current_blink_mode;
-    unsigned long blink_start_time;
-    unsigned long last_blink_toggle;
+    Instant blink_start_time;
+    Instant last_blink_toggle;
     bool blink_state;
     static const unsigned long BLINK_TIMEOUT = 3000;     // 3 seconds
     static const unsigned long BLINK_PERIOD = 500;       // 0.5 seconds
     static const unsigned long BLINK_ON_TIME = 400;      // 80% of 500ms = 400ms
-    static const unsigned long BLINK_OFF_TIME = 1;     // 20% of 500ms = 100ms
+    static const unsigned long BLINK_OFF_TIME = 100;     // 20% of 500ms = 100ms
     
     void showTimePrivate(int seconds);
+    void showHundredths(unsigned long remaining_ms);
+    void writeFrame(const uint8_t segments[4]);
     void updateBlinking();
     void showTimeWithBlink(int seconds);
-    uint8_t getDigit(int value, int position);
 };
 
 #endif
\ No newline at end of file
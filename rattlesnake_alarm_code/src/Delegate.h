@@ -0,0 +1,48 @@
+#ifndef DELEGATE_H
+#define DELEGATE_H
+
+#include <new>
+#include <type_traits>
+
+// Fixed-size replacement for std::function that never allocates. It holds
+// any trivially copyable callable of up to two pointers (function pointers,
+// captureless lambdas, lambdas capturing a pointer or two) inline and calls
+// it through one plain function pointer. A default-constructed delegate
+// does nothing and returns R().
+template <typename Signature>
+class Delegate;
+
+template <typename R, typename... Args>
+class Delegate<R(Args...)> {
+  public:
+    Delegate() : storage{}, invoker(&invokeNothing) {}
+
+    template <typename F,
+              typename = typename std::enable_if<
+                !std::is_same<typename std::decay<F>::type, Delegate>::value>::type>
+    Delegate(F callable) : storage{} {
+      static_assert(sizeof(F) <= sizeof(storage), "Callable is too large for Delegate");
+      static_assert(std::is_trivially_copyable<F>::value, "Delegate callables must be trivially copyable");
+      new (storage) F(callable);
+      invoker = &invokeCallable<F>;
+    }
+
+    R operator()(Args... args) const {
+      return invoker(storage, args...);
+    }
+
+  private:
+    alignas(void*) unsigned char storage[2 * sizeof(void*)];
+    R (*invoker)(const void* callable, Args... args);
+
+    template <typename F>
+    static R invokeCallable(const void* callable, Args... args) {
+      return (*static_cast<const F*>(callable))(args...);
+    }
+
+    static R invokeNothing(const void*, Args...) {
+      return R();
+    }
+};
+
+#endif
@@ -0,0 +1,107 @@
+#include "DisplayEffects.h"
+
+static const char* const modeNames[] = { "NONE", "BLINK", "FADE", "PULSE" };
+
+DisplayEffects::DisplayEffects(MirroredDisplay& display)
+  : display(display),
+    mode(EFFECT_NONE),
+    level(7),
+    from_level(7),
+    to_level(7),
+    started{0},
+    period_ms(0),
+    sent_level(7),
+    sent_on(true) {}
+
+void DisplayEffects::blink(unsigned long period) {
+  begin(EFFECT_BLINK, period);
+}
+
+// Linear from the current level; the display stays at to_level afterwards
+void DisplayEffects::fade(uint8_t to, unsigned long duration_ms) {
+  from_level = sent_on ? sent_level : 0;
+  to_level = to > 7 ? 7 : to;
+  begin(EFFECT_FADE, duration_ms);
+}
+
+void DisplayEffects::pulse(unsigned long period) {
+  begin(EFFECT_PULSE, period);
+}
+
+void DisplayEffects::stop() {
+  mode = EFFECT_NONE;
+  send(level, true);
+}
+
+void DisplayEffects::update() {
+  if (mode == EFFECT_NONE) {
+    return;
+  }
+
+  unsigned long elapsed = (Timebase::now() - started).toMillis();
+  switch (mode) {
+    case EFFECT_BLINK:
+      // On for the first half of each period, off for the second
+      send(level, (elapsed % period_ms) < period_ms / 2);
+      break;
+
+    case EFFECT_FADE:
+      if (elapsed >= period_ms) {
+        send(to_level, true);
+        mode = EFFECT_NONE;
+      } else {
+        int span = (int)to_level - (int)from_level;
+        send(from_level + span * (long)elapsed / (long)period_ms, true);
+      }
+      break;
+
+    case EFFECT_PULSE: {
+      // Triangle wave from 0 up to level and back over one period
+      unsigned long phase = elapsed % period_ms;
+      unsigned long half = period_ms / 2;
+      unsigned long ramp = phase < half ? phase : period_ms - phase;
+      send(level * ramp / half, true);
+      break;
+    }
+
+    default:
+      break;
+  }
+}
+
+void DisplayEffects::setLevel(uint8_t newLevel) {
+  level = newLevel > 7 ? 7 : newLevel;
+  if (mode == EFFECT_NONE) {
+    send(level, true);
+  }
+}
+
+uint8_t DisplayEffects::getLevel() {
+  return level;
+}
+
+EffectMode DisplayEffects::getMode() {
+  return mode;
+}
+
+const char* DisplayEffects::modeName(EffectMode m) {
+  return m <= EFFECT_PULSE ? modeNames[m] : "UNKNOWN";
+}
+
+void DisplayEffects::begin(EffectMode newMode, unsigned long period) {
+  // Two steps minimum so blink and pulse have both halves
+  period_ms = period < 2 ? 2 : period;
+  started = Timebase::now();
+  mode = newMode;
+  update();
+}
+
+// Only changes go out on the bus
+void DisplayEffects::send(uint8_t newLevel, bool on) {
+  if (newLevel == sent_level && on == sent_on) {
+    return;
+  }
+  sent_level = newLevel;
+  sent_on = on;
+  display.setDisplayControl(newLevel, on);
+}
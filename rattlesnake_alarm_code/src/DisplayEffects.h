@@ -0,0 +1,43 @@
+#ifndef DISPLAY_EFFECTS_H
+#define DISPLAY_EFFECTS_H
+
+#include <Arduino.h>
+#include "MirroredDisplay.h"
+#include "Timebase.h"
+
+enum EffectMode { EFFECT_NONE, EFFECT_BLINK, EFFECT_FADE, EFFECT_PULSE };
+
+// Whole-display effects driven only through the display control byte, so a
+// step costs one byte on the bus and whatever the digits show is left alone
+class DisplayEffects {
+  public:
+    DisplayEffects(MirroredDisplay& display);
+
+    void blink(unsigned long period);
+    void fade(uint8_t to_level, unsigned long duration_ms);
+    void pulse(unsigned long period);
+    void stop();
+    void update();
+
+    // Level (0-7) restored by stop() and used as the top of blink and pulse
+    void setLevel(uint8_t level);
+    uint8_t getLevel();
+    EffectMode getMode();
+    static const char* modeName(EffectMode mode);
+
+  private:
+    MirroredDisplay& display;
+    EffectMode mode;
+    uint8_t level;
+    uint8_t from_level;
+    uint8_t to_level;
+    Instant started;
+    unsigned long period_ms;
+    uint8_t sent_level;
+    bool sent_on;
+
+    void begin(EffectMode newMode, unsigned long period);
+    void send(uint8_t newLevel, bool on);
+};
+
+#endif
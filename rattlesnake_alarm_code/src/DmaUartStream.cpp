@@ -0,0 +1,147 @@
+#include "DmaUartStream.h"
+#include "hardware/dma.h"
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+
+// The channel counts down from here; at 115200 baud that lasts over four
+// days of continuous traffic before pending() has to restart it
+static const uint32_t TRANSFER_COUNT = 0xFFFFFFFF;
+
+void (*DmaUartStream::wake_handler)() = nullptr;
+DmaUartStream* DmaUartStream::wake_stream = nullptr;
+
+DmaUartStream::DmaUartStream(uart_inst_t* uart, uint8_t txPin, uint8_t rxPin, int dePin)
+  : uart(uart),
+    tx_pin(txPin),
+    rx_pin(rxPin),
+    de_pin(dePin),
+    dma_channel(-1),
+    consumed(0),
+    tail(0),
+    overruns(0) {}
+
+// The baud divisor is computed from clk_peri, which PowerManager keeps on
+// the USB PLL, so it holds across dormant idle
+void DmaUartStream::begin(unsigned long baud) {
+  // uart_init() also enables the UART's DMA requests
+  uart_init(uart, baud);
+  gpio_set_function(tx_pin, GPIO_FUNC_UART);
+  gpio_set_function(rx_pin, GPIO_FUNC_UART);
+  if (de_pin >= 0) {
+    gpio_init(de_pin);
+    gpio_set_dir(de_pin, GPIO_OUT);
+    gpio_put(de_pin, 0);
+  }
+
+  dma_channel = dma_claim_unused_channel(false);
+  if (dma_channel < 0) {
+    return;
+  }
+  dma_channel_config config = dma_channel_get_default_config(dma_channel);
+  channel_config_set_transfer_data_size(&config, DMA_SIZE_8);
+  channel_config_set_read_increment(&config, false);
+  channel_config_set_write_increment(&config, true);
+  channel_config_set_ring(&config, true, RING_BITS);
+  channel_config_set_dreq(&config, uart_get_index(uart) ? DREQ_UART1_RX : DREQ_UART0_RX);
+  dma_channel_configure(dma_channel, &config, ring, &uart_get_hw(uart)->dr, TRANSFER_COUNT, true);
+
+  irq_set_exclusive_handler(uart_get_index(uart) ? UART1_IRQ : UART0_IRQ, onUartIrq);
+}
+
+int DmaUartStream::available() {
+  return pending();
+}
+
+int DmaUartStream::read() {
+  if (pending() == 0) {
+    return -1;
+  }
+  uint8_t b = ring[tail];
+  tail = (tail + 1) % RING_SIZE;
+  consumed++;
+  return b;
+}
+
+int DmaUartStream::peek() {
+  return pending() > 0 ? ring[tail] : -1;
+}
+
+size_t DmaUartStream::write(uint8_t b) {
+  return write(&b, 1);
+}
+
+size_t DmaUartStream::write(const uint8_t* buffer, size_t size) {
+  if (de_pin >= 0) {
+    gpio_put(de_pin, 1);
+  }
+  uart_write_blocking(uart, buffer, size);
+  if (de_pin >= 0) {
+    // Hold the bus until the last stop bit is out
+    uart_tx_wait_blocking(uart);
+    gpio_put(de_pin, 0);
+  }
+  return size;
+}
+
+void DmaUartStream::flush() {
+  uart_tx_wait_blocking(uart);
+}
+
+void DmaUartStream::armWake(void (*onReceive)()) {
+  wake_handler = onReceive;
+  wake_stream = this;
+
+  uart_hw_t* hw = uart_get_hw(uart);
+  hw_clear_bits(&hw->dmacr, UART_UARTDMACR_RXDMAE_BITS);
+  hw->imsc = UART_UARTIMSC_RXIM_BITS | UART_UARTIMSC_RTIM_BITS;
+  irq_set_enabled(uart_get_index(uart) ? UART1_IRQ : UART0_IRQ, true);
+}
+
+// Bytes that arrived meanwhile are still in the FIFO and go to the ring as
+// soon as the DMA request is back on
+void DmaUartStream::disarmWake() {
+  uart_hw_t* hw = uart_get_hw(uart);
+  hw->imsc = 0;
+  irq_set_enabled(uart_get_index(uart) ? UART1_IRQ : UART0_IRQ, false);
+  hw_set_bits(&hw->dmacr, UART_UARTDMACR_RXDMAE_BITS);
+}
+
+unsigned long DmaUartStream::getOverruns() {
+  return overruns;
+}
+
+// Bytes written by the DMA and not yet read
+uint32_t DmaUartStream::pending() {
+  if (dma_channel < 0) {
+    return 0;
+  }
+
+  // Restart a channel that has used up its count; the write address carries
+  // on where it was, and consumed is rebased onto the new count
+  if (!dma_channel_is_busy(dma_channel)) {
+    consumed -= TRANSFER_COUNT;
+    dma_channel_set_trans_count(dma_channel, TRANSFER_COUNT, true);
+  }
+
+  uint32_t produced = TRANSFER_COUNT - dma_hw->ch[dma_channel].transfer_count;
+  uint32_t backlog = produced - consumed;
+  if (backlog > RING_SIZE) {
+    // The DMA has lapped the reader; the oldest bytes are already gone
+    uint32_t lost = backlog - RING_SIZE;
+    consumed += lost;
+    tail = (tail + lost) % RING_SIZE;
+    overruns++;
+    backlog = RING_SIZE;
+  }
+  return backlog;
+}
+
+// Masking the interrupt leaves the byte in the FIFO for disarmWake()
+void DmaUartStream::onUartIrq() {
+  if (wake_stream) {
+    uart_get_hw(wake_stream->uart)->imsc = 0;
+  }
+  if (wake_handler) {
+    wake_handler();
+  }
+}
@@ -0,0 +1,54 @@
+#ifndef DMA_UART_STREAM_H
+#define DMA_UART_STREAM_H
+
+#include <Arduino.h>
+#include "hardware/uart.h"
+
+// Stream over a hardware UART whose receive side is a DMA channel writing
+// into a ring buffer, so received bytes cost no interrupt or polling; the
+// reader just compares its position with the DMA transfer count. Transmit
+// is blocking and can drive an RS-485 driver-enable pin around each write.
+class DmaUartStream : public Stream {
+  public:
+    DmaUartStream(uart_inst_t* uart, uint8_t txPin, uint8_t rxPin, int dePin = -1);
+
+    void begin(unsigned long baud);
+
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t write(uint8_t b) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    void flush() override;
+    using Print::write;
+
+    // While dormant nothing reads the ring and the DMA raises no interrupt,
+    // so reception is handed back to the UART FIFO and its interrupt calls
+    // onReceive for the first byte
+    void armWake(void (*onReceive)());
+    void disarmWake();
+
+    unsigned long getOverruns();
+
+    static const uint8_t RING_BITS = 8;
+    static const size_t RING_SIZE = 1 << RING_BITS;
+
+  private:
+    uart_inst_t* uart;
+    uint8_t tx_pin;
+    uint8_t rx_pin;
+    int de_pin;
+    int dma_channel;
+    uint32_t consumed;
+    size_t tail;
+    unsigned long overruns;
+    alignas(RING_SIZE) uint8_t ring[RING_SIZE];
+
+    uint32_t pending();
+
+    static void (*wake_handler)();
+    static DmaUartStream* wake_stream;
+    static void onUartIrq();
+};
+
+#endif
@@ -0,0 +1,143 @@
+#include "MirroredDisplay.h"
+#include "Timebase.h"
+
+// TM1637_I2C_COMM3 in the library, which does not export it
+static const uint8_t DISPLAY_CONTROL_COMMAND = 0x80;
+
+MirroredDisplay::MirroredDisplay(uint8_t pinClk, uint8_t pinDIO, unsigned int bitDelay)
+  : TM1637Display(pinClk, pinDIO, bitDelay),
+    shown{0, 0, 0, 0},
+    pending_brightness(0),
+    shown_brightness(0),
+    sequence(0),
+    mirror(nullptr) {}
+
+void MirroredDisplay::setSegments(const uint8_t segments[], uint8_t length, uint8_t pos) {
+  TM1637Display::setSegments(segments, length, pos);
+
+  uint8_t changed = 0;
+  for (uint8_t i = 0; i < length && pos + i < 4; i++) {
+    if (shown[pos + i] != segments[i]) {
+      shown[pos + i] = segments[i];
+      changed |= 1 << (pos + i);
+    }
+  }
+
+  // The module only picks up a new brightness with the next segment write
+  bool brightness_changed = pending_brightness != shown_brightness;
+  shown_brightness = pending_brightness;
+
+  if (mirror) {
+    if (changed) {
+      emitFrame(changed);
+    }
+    if (brightness_changed) {
+      emitBrightness();
+    }
+  }
+}
+
+void MirroredDisplay::setBrightness(uint8_t brightness, bool on) {
+  TM1637Display::setBrightness(brightness, on);
+  pending_brightness = (brightness & 0x07) | (on ? 0x08 : 0x00);
+}
+
+void MirroredDisplay::setDisplayControl(uint8_t brightness, bool on) {
+  // Keeps the base class in step so the next setSegments sends the same
+  TM1637Display::setBrightness(brightness, on);
+  pending_brightness = (brightness & 0x07) | (on ? 0x08 : 0x00);
+
+  start();
+  writeByte(DISPLAY_CONTROL_COMMAND | pending_brightness);
+  stop();
+
+  if (pending_brightness != shown_brightness) {
+    shown_brightness = pending_brightness;
+    if (mirror) {
+      emitBrightness();
+    }
+  }
+}
+
+void MirroredDisplay::clear() {
+  const uint8_t blank[] = {0, 0, 0, 0};
+  setSegments(blank);
+}
+
+// Same output as TM1637Display::showNumberDecEx for the non-negative
+// numbers used here, routed through the mirrored setSegments
+void MirroredDisplay::showNumberDecEx(int num, uint8_t dots, bool leading_zero, uint8_t length, uint8_t pos) {
+  uint8_t digits[4] = {0, 0, 0, 0};
+  if (length > 4) {
+    length = 4;
+  }
+
+  bool negative = num < 0;
+  unsigned int value = negative ? -num : num;
+  for (int i = length - 1; i >= 0; i--) {
+    if (value == 0 && i < length - 1 && !leading_zero) {
+      digits[i] = (negative ? SEG_G : 0);
+      negative = false;
+    } else {
+      digits[i] = encodeDigit(value % 10);
+      value /= 10;
+    }
+  }
+
+  for (int i = 0; i < 4; i++) {
+    digits[i] |= (dots & 0x80);
+    dots <<= 1;
+  }
+  setSegments(digits, length, pos);
+}
+
+void MirroredDisplay::setMirror(Print* out) {
+  mirror = out;
+  if (mirror) {
+    // Start with a full frame so the receiver has a baseline
+    emitFrame(0x0F);
+    emitBrightness();
+  }
+}
+
+bool MirroredDisplay::isMirroring() {
+  return mirror != nullptr;
+}
+
+void MirroredDisplay::getFrame(uint8_t frame[4]) {
+  memcpy(frame, shown, sizeof(shown));
+}
+
+void MirroredDisplay::emitFrame(uint8_t mask) {
+  mirror->print("@D ");
+  mirror->print(++sequence);
+  mirror->print(' ');
+  mirror->print((unsigned long)Timebase::now().toMillis());
+  mirror->print(' ');
+  mirror->print(mask, HEX);
+  for (int i = 0; i < 4; i++) {
+    if (mask & (1 << i)) {
+      mirror->print(' ');
+      printHex(shown[i]);
+    }
+  }
+  mirror->println();
+}
+
+void MirroredDisplay::emitBrightness() {
+  mirror->print("@B ");
+  mirror->print(++sequence);
+  mirror->print(' ');
+  mirror->print((unsigned long)Timebase::now().toMillis());
+  mirror->print(' ');
+  mirror->print(shown_brightness & 0x07);
+  mirror->print(' ');
+  mirror->println((shown_brightness & 0x08) ? 1 : 0);
+}
+
+void MirroredDisplay::printHex(uint8_t value) {
+  if (value < 0x10) {
+    mirror->print('0');
+  }
+  mirror->print(value, HEX);
+}
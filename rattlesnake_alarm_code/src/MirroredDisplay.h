@@ -0,0 +1,41 @@
+#ifndef MIRRORED_DISPLAY_H
+#define MIRRORED_DISPLAY_H
+
+#include <Arduino.h>
+#include <TM1637Display.h>
+
+// TM1637Display that keeps a copy of what the module is showing and, when
+// mirroring is on, reports every change as a compact record:
+//   @D <seq> <ms> <mask> <byte>...   changed digits (mask bit n = digit n)
+//   @B <seq> <ms> <level> <on>       brightness as applied by the module
+// Bytes and mask are hex. The TM1637Display methods are not virtual, so code
+// must hold a MirroredDisplay (not a TM1637Display) for writes to be seen.
+class MirroredDisplay : public TM1637Display {
+  public:
+    MirroredDisplay(uint8_t pinClk, uint8_t pinDIO, unsigned int bitDelay = DEFAULT_BIT_DELAY);
+
+    void setSegments(const uint8_t segments[], uint8_t length = 4, uint8_t pos = 0);
+    void setBrightness(uint8_t brightness, bool on = true);
+    // Applies brightness and on/off right away with the one-byte display
+    // control command; the digits are not resent
+    void setDisplayControl(uint8_t brightness, bool on = true);
+    void clear();
+    void showNumberDecEx(int num, uint8_t dots = 0, bool leading_zero = false, uint8_t length = 4, uint8_t pos = 0);
+
+    void setMirror(Print* out);
+    bool isMirroring();
+    void getFrame(uint8_t frame[4]);
+
+  private:
+    uint8_t shown[4];
+    uint8_t pending_brightness;
+    uint8_t shown_brightness;
+    unsigned long sequence;
+    Print* mirror;
+
+    void emitFrame(uint8_t mask);
+    void emitBrightness();
+    void printHex(uint8_t value);
+};
+
+#endif
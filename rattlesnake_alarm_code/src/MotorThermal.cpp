@@ -0,0 +1,112 @@
+#include "MotorThermal.h"
+
+MotorThermal::MotorThermal()
+  : capacity_ms(5000),
+    cooling_ms(60000),
+    heat(0),
+    duty(0),
+    tripped(false),
+    trip_count(0),
+    last_update{0} {}
+
+// Euler steps of at most 1/16 of the time constant keep the decay close to
+// exponential. The decay is rounded up so an idle motor reaches zero rather
+// than stalling where the truncated term becomes 0. After SETTLE_CONSTANTS
+// time constants the state is within e^-8 of where it settles, so a longer
+// gap (e.g. days of dormant idle) is cut to that and stays a bounded loop.
+void MotorThermal::update(Instant now) {
+  uint64_t elapsed = (now - last_update).toMillis();
+  if (elapsed == 0) {
+    return;
+  }
+  last_update = now;
+
+  uint64_t settle = (uint64_t)cooling_ms * SETTLE_CONSTANTS;
+  unsigned long dt = elapsed < settle ? (unsigned long)elapsed : (unsigned long)settle;
+  unsigned long max_step = cooling_ms / 16 > 0 ? cooling_ms / 16 : 1;
+  while (dt > 0 && (heat > 0 || duty > 0)) {
+    unsigned long step = dt < max_step ? dt : max_step;
+    heat += (uint64_t)duty * step;
+    heat -= (heat * step + cooling_ms - 1) / cooling_ms;
+    dt -= step;
+  }
+
+  if (heat >= capacity()) {
+    if (!tripped) {
+      trip_count++;
+    }
+    tripped = true;
+  } else if (tripped && heat * 100 < capacity() * RESUME_LEVEL) {
+    tripped = false;
+  }
+}
+
+void MotorThermal::setDuty(uint16_t permille, Instant now) {
+  update(now);
+  duty = permille > 1000 ? 1000 : permille;
+}
+
+bool MotorThermal::mayRun() {
+  return !tripped;
+}
+
+uint16_t MotorThermal::maxDuty() {
+  if (tripped) {
+    return 0;
+  }
+  uint64_t derate_from = capacity() * DERATE_START / 100;
+  if (heat <= derate_from) {
+    return 1000;
+  }
+  uint64_t span = capacity() - derate_from;
+  uint64_t into = heat - derate_from;
+  return 1000 - (uint16_t)((1000 - MIN_DUTY) * into / span);
+}
+
+uint8_t MotorThermal::getHeatPercent() {
+  uint64_t percent = heat * 100 / capacity();
+  return percent > 100 ? 100 : (uint8_t)percent;
+}
+
+void MotorThermal::restore(uint8_t heat_percent, bool was_tripped, Instant now) {
+  heat = capacity() * (heat_percent > 100 ? 100 : heat_percent) / 100;
+  tripped = was_tripped;
+  last_update = now;
+  update(now);
+}
+
+// Capacity must be below what full duty settles at (the time constant),
+// otherwise the limit could never be reached
+bool MotorThermal::configure(unsigned long newCapacity, unsigned long newCooling) {
+  if (newCapacity == 0 || newCooling == 0 || newCapacity >= newCooling) {
+    return false;
+  }
+  capacity_ms = newCapacity;
+  cooling_ms = newCooling;
+  return true;
+}
+
+void MotorThermal::printStatus(Print& out) {
+  out.print("Motor heat: ");
+  out.print(getHeatPercent());
+  out.print("% of ");
+  out.print(capacity_ms);
+  out.println("ms at full duty");
+  out.print("Cooling time constant: ");
+  out.print(cooling_ms);
+  out.println("ms");
+  out.print("Duty: ");
+  out.print(duty / 10);
+  out.print("%, allowed: ");
+  out.print(maxDuty() / 10);
+  out.println("%");
+  out.print("Tripped: ");
+  out.print(tripped ? "yes" : "no");
+  out.print(" (");
+  out.print(trip_count);
+  out.println(" trips)");
+}
+
+uint64_t MotorThermal::capacity() {
+  return (uint64_t)capacity_ms * 1000;
+}
@@ -0,0 +1,51 @@
+#ifndef MOTOR_THERMAL_H
+#define MOTOR_THERMAL_H
+
+#include <Arduino.h>
+#include "Timebase.h"
+
+// First-order thermal model of the motor: heat grows with duty x time and
+// decays exponentially with the cooling time constant. Heat is kept in
+// full-duty milliseconds, so the capacity reads as "ms at 100% from cold".
+//
+// Below DERATE_START of capacity any duty is allowed; from there to full
+// capacity the allowed duty falls linearly to MIN_DUTY. At capacity the
+// limiter trips and the motor may not run until heat is back under
+// RESUME_LEVEL.
+class MotorThermal {
+  public:
+    MotorThermal();
+
+    void update(Instant now);
+    // Duty in permille that is applied from now on
+    void setDuty(uint16_t permille, Instant now);
+
+    bool mayRun();
+    uint16_t maxDuty();
+    uint8_t getHeatPercent();
+
+    // Picks up the estimate saved before a warm reset; no cooling is
+    // credited for the time the reset took
+    void restore(uint8_t heat_percent, bool was_tripped, Instant now);
+
+    bool configure(unsigned long capacity_ms, unsigned long cooling_ms);
+    void printStatus(Print& out);
+
+    static const uint16_t DERATE_START = 80; // percent of capacity
+    static const uint16_t RESUME_LEVEL = 50; // percent of capacity
+    static const uint16_t MIN_DUTY = 250;    // permille
+
+  private:
+    static const unsigned long SETTLE_CONSTANTS = 8; // time constants
+    unsigned long capacity_ms;
+    unsigned long cooling_ms;
+    uint64_t heat;      // permille x ms
+    uint16_t duty;      // permille
+    bool tripped;
+    unsigned long trip_count;
+    Instant last_update;
+
+    uint64_t capacity();
+};
+
+#endif
@@ -0,0 +1,134 @@
+#include "PowerManager.h"
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+#include "hardware/pll.h"
+#include "hardware/sync.h"
+
+static const uint32_t USB_PLL_HZ = 48 * MHZ;
+
+volatile bool PowerManager::wake_pending = false;
+
+PowerManager::PowerManager()
+  : idle_timeout(60000),
+    last_activity{0},
+    wake_count(0),
+    usb_wake_count(0),
+    residency_ms(0),
+    dormant(false) {}
+
+// clk_peri moves to the USB PLL for good, so the UART baud divisors stay
+// valid while sleep() changes clk_sys. Peripherals set up later (the UART
+// link) compute their dividers from this clock.
+void PowerManager::begin() {
+  clock_configure(clk_peri, 0, CLOCKS_CLK_PERI_CTRL_AUXSRC_VALUE_CLKSRC_PLL_USB, USB_PLL_HZ, USB_PLL_HZ);
+  last_activity = Timebase::now();
+}
+
+void PowerManager::onWakeEdge() {
+  wake_pending = true;
+}
+
+void PowerManager::update(bool idle) {
+  Instant now = Timebase::now();
+
+  // Any pin edge since the last pass counts as activity
+  if (wake_pending || !idle) {
+    wake_pending = false;
+    last_activity = now;
+    return;
+  }
+
+  if (idle_timeout > 0 && now - last_activity >= Duration::fromMillis(idle_timeout)) {
+    sleep();
+  }
+}
+
+void PowerManager::noteActivity() {
+  last_activity = Timebase::now();
+}
+
+void PowerManager::setSleepHandlers(Delegate<void()> sleepFunc, Delegate<void()> wakeFunc) {
+  onSleep = sleepFunc;
+  onWake = wakeFunc;
+}
+
+void PowerManager::sleep() {
+  // The TM1637 latches its last frame, so the display needs nothing here.
+  // clk_usb and clk_peri run from the USB PLL, so USB CDC and the UART link
+  // keep their rates at the reduced system clock and incoming data still
+  // wakes us, without a byte being lost to the switch.
+  uint32_t full_hz = clock_get_hz(clk_sys);
+  Instant start = Timebase::now();
+
+  dormant = true;
+  clock_configure(clk_sys, CLOCKS_CLK_SYS_CTRL_SRC_VALUE_CLKSRC_CLK_SYS_AUX,
+                  CLOCKS_CLK_SYS_CTRL_AUXSRC_VALUE_CLKSRC_PLL_USB, USB_PLL_HZ, USB_PLL_HZ);
+  pll_deinit(pll_sys);
+  onSleep();
+
+  // Interrupts stay masked from each check to the WFI, so an edge cannot
+  // land in between and leave us asleep; a pending IRQ still ends the WFI
+  // and is taken once they are unmasked
+  uint32_t irq_state = save_and_disable_interrupts();
+  while (!wake_pending && !Serial.available()) {
+    __wfi();
+    restore_interrupts(irq_state);
+    irq_state = save_and_disable_interrupts();
+  }
+  restore_interrupts(irq_state);
+
+  uint vco_hz, post_div1, post_div2;
+  check_sys_clock_khz(full_hz / 1000, &vco_hz, &post_div1, &post_div2);
+  pll_init(pll_sys, 1, vco_hz, post_div1, post_div2);
+  clock_configure(clk_sys, CLOCKS_CLK_SYS_CTRL_SRC_VALUE_CLKSRC_CLK_SYS_AUX,
+                  CLOCKS_CLK_SYS_CTRL_AUXSRC_VALUE_CLKSRC_PLL_SYS, full_hz, full_hz);
+  dormant = false;
+  onWake();
+  wake_count++;
+  if (!wake_pending) {
+    usb_wake_count++;
+  }
+
+  // Leave wake_pending set so the next update() treats the edge as activity;
+  // the input itself is picked up by the normal polling in loop().
+  last_activity = Timebase::now();
+  residency_ms += (last_activity - start).toMillis();
+}
+
+void PowerManager::setIdleTimeout(unsigned long ms) {
+  idle_timeout = ms;
+}
+
+unsigned long PowerManager::getIdleTimeout() {
+  return idle_timeout;
+}
+
+bool PowerManager::isDormant() {
+  return dormant;
+}
+
+unsigned long PowerManager::getWakeCount() {
+  return wake_count;
+}
+
+unsigned long PowerManager::getUsbWakeCount() {
+  return usb_wake_count;
+}
+
+unsigned long PowerManager::getResidencyMs() {
+  return residency_ms;
+}
+
+void PowerManager::printStatus(Print& out) {
+  out.print("Idle timeout: ");
+  out.print(idle_timeout);
+  out.println("ms");
+  out.print("Wakes: ");
+  out.print(wake_count);
+  out.print(" (USB: ");
+  out.print(usb_wake_count);
+  out.println(")");
+  out.print("Dormant residency: ");
+  out.print(residency_ms);
+  out.println("ms");
+}
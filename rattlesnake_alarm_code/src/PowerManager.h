@@ -0,0 +1,43 @@
+#ifndef POWER_MANAGER_H
+#define POWER_MANAGER_H
+
+#include <Arduino.h>
+#include "Timebase.h"
+#include "Delegate.h"
+
+class PowerManager {
+  public:
+    PowerManager();
+
+    void begin();
+    void update(bool idle);
+    void noteActivity();
+    // Run once the reduced clock is set and again once the full clock is back
+    void setSleepHandlers(Delegate<void()> onSleep, Delegate<void()> onWake);
+
+    void setIdleTimeout(unsigned long ms);
+    unsigned long getIdleTimeout();
+    bool isDormant();
+    unsigned long getWakeCount();
+    unsigned long getUsbWakeCount();
+    unsigned long getResidencyMs();
+    void printStatus(Print& out);
+
+    // Reports a wake from an input's own edge ISR
+    static void onWakeEdge();
+
+  private:
+    unsigned long idle_timeout;
+    Instant last_activity;
+    unsigned long wake_count;
+    unsigned long usb_wake_count;
+    unsigned long residency_ms;
+    bool dormant;
+    static volatile bool wake_pending;
+    Delegate<void()> onSleep;
+    Delegate<void()> onWake;
+
+    void sleep();
+};
+
+#endif
@@ -0,0 +1,40 @@
+#include "QuadratureEncoder.h"
+
+static const uint8_t REST = 0x3; // both pins pulled high between detents
+
+// Indexed by (previous state << 2) | new state. A leading B goes
+// 11 -> 01 -> 00 -> 10 -> 11; no change or a double step counts as 0.
+static const int8_t TRANSITIONS[16] = {
+   0, -1, +1,  0,
+  +1,  0,  0, -1,
+  -1,  0,  0, +1,
+   0, +1, -1,  0,
+};
+
+QuadratureEncoder::QuadratureEncoder()
+  : state(REST),
+    steps(0),
+    detents(0) {}
+
+void QuadratureEncoder::onEdge(bool a, bool b) {
+  uint8_t next = (a ? 0x2 : 0) | (b ? 0x1 : 0);
+  steps += TRANSITIONS[(state << 2) | next];
+  state = next;
+
+  if (state == REST) {
+    if (steps >= 4) {
+      detents = detents + 1;
+    } else if (steps <= -4) {
+      detents = detents - 1;
+    }
+    steps = 0;
+  }
+}
+
+int QuadratureEncoder::takeDetents() {
+  noInterrupts();
+  int taken = detents;
+  detents = 0;
+  interrupts();
+  return taken;
+}
@@ -0,0 +1,27 @@
+#ifndef QUADRATURE_ENCODER_H
+#define QUADRATURE_ENCODER_H
+
+#include <Arduino.h>
+
+// Detented quadrature encoder decoded from a table of Gray-code transitions.
+// Both pins interrupt on every edge. Contact bounce on one pin only steps
+// back and forth between two neighbouring states and cancels out, and a
+// jump across two states (a missed edge) counts as nothing, so no settle
+// time is needed. A detent counts once the pins are back at rest (both
+// high) after four steps in the same direction.
+class QuadratureEncoder {
+  public:
+    QuadratureEncoder();
+
+    // Called from the edge interrupt of either pin with both pin levels
+    void onEdge(bool a, bool b);
+    // Detents since the last call, positive for A leading B
+    int takeDetents();
+
+  private:
+    uint8_t state;        // (A << 1) | B as of the last edge
+    int8_t steps;         // quarter steps since the pins were last at rest
+    volatile int detents;
+};
+
+#endif
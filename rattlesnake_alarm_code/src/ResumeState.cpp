@@ -0,0 +1,89 @@
+#include "ResumeState.h"
+#include "hardware/structs/watchdog.h"
+#include "hardware/structs/vreg_and_chip_reset.h"
+
+// scratch[4..7] are used by the bootrom for watchdog reboots, so stay in 0..3
+enum { SCRATCH_MAGIC, SCRATCH_REMAINING, SCRATCH_SETTINGS, SCRATCH_CHECK };
+
+uint32_t ResumeState::checksum(uint32_t a, uint32_t b, uint32_t c) {
+  uint32_t sum = a ^ 0xA5A5A5A5;
+  sum = ((sum << 7) | (sum >> 25)) ^ b;
+  sum = ((sum << 7) | (sum >> 25)) ^ c;
+  return sum;
+}
+
+void ResumeState::save(unsigned long remaining_ms, int default_seconds, bool running, bool alarm_pending,
+                       uint8_t heat_percent, bool motor_tripped) {
+  // Heat is rounded up so a resumed estimate never runs cooler
+  uint32_t heat = ((uint32_t)(heat_percent > 100 ? 100 : heat_percent) * 31 + 99) / 100;
+  uint32_t settings = ((uint32_t)default_seconds & 0x00FFFFFF)
+    | (running ? FLAG_RUNNING : 0)
+    | (alarm_pending ? FLAG_ALARM : 0)
+    | (heat << HEAT_SHIFT)
+    | (motor_tripped ? FLAG_TRIPPED : 0);
+
+  watchdog_hw->scratch[SCRATCH_MAGIC] = MAGIC;
+  watchdog_hw->scratch[SCRATCH_REMAINING] = remaining_ms;
+  watchdog_hw->scratch[SCRATCH_SETTINGS] = settings;
+  watchdog_hw->scratch[SCRATCH_CHECK] = checksum(MAGIC, remaining_ms, settings);
+}
+
+bool ResumeState::load(ResumeSnapshot& snapshot) {
+  uint32_t magic = watchdog_hw->scratch[SCRATCH_MAGIC];
+  uint32_t remaining = watchdog_hw->scratch[SCRATCH_REMAINING];
+  uint32_t settings = watchdog_hw->scratch[SCRATCH_SETTINGS];
+
+  if (magic != MAGIC || watchdog_hw->scratch[SCRATCH_CHECK] != checksum(magic, remaining, settings)) {
+    return false;
+  }
+
+  snapshot.remaining_ms = remaining;
+  snapshot.default_seconds = settings & 0x00FFFFFF;
+  snapshot.running = (settings & FLAG_RUNNING) != 0;
+  snapshot.alarm_pending = (settings & FLAG_ALARM) != 0;
+  snapshot.heat_percent = (((settings & HEAT_MASK) >> HEAT_SHIFT) * 100 + 30) / 31;
+  snapshot.motor_tripped = (settings & FLAG_TRIPPED) != 0;
+  return true;
+}
+
+void ResumeState::clear() {
+  watchdog_hw->scratch[SCRATCH_MAGIC] = 0;
+}
+
+bool ResumeState::wasWatchdogTimeout() {
+  return (watchdog_hw->reason & WATCHDOG_REASON_TIMER_BITS) != 0;
+}
+
+// The SDK's watchdog selects every block but the oscillators in PSM WDSEL,
+// and RUN and power-on reset the whole chip. SYSRESETREQ and a debugger
+// restart only reset the cores, and the TIMER keeps counting from before.
+bool ResumeState::timerWasReset() {
+  if (watchdog_hw->reason & (WATCHDOG_REASON_TIMER_BITS | WATCHDOG_REASON_FORCE_BITS)) {
+    return true;
+  }
+  uint32_t chip = vreg_and_chip_reset_hw->chip_reset;
+  return (chip & (VREG_AND_CHIP_RESET_CHIP_RESET_HAD_POR_BITS | VREG_AND_CHIP_RESET_CHIP_RESET_HAD_RUN_BITS)) != 0;
+}
+
+const char* ResumeState::resetReason() {
+  uint32_t reason = watchdog_hw->reason;
+  if (wasWatchdogTimeout()) {
+    return "watchdog timeout";
+  }
+  if (reason & WATCHDOG_REASON_FORCE_BITS) {
+    return "watchdog reboot";
+  }
+
+  uint32_t chip = vreg_and_chip_reset_hw->chip_reset;
+  if (chip & VREG_AND_CHIP_RESET_CHIP_RESET_HAD_POR_BITS) {
+    return "power-on or brownout";
+  }
+  if (chip & VREG_AND_CHIP_RESET_CHIP_RESET_HAD_RUN_BITS) {
+    return "RUN pin";
+  }
+  if (chip & VREG_AND_CHIP_RESET_CHIP_RESET_HAD_PSM_RESTART_BITS) {
+    return "debugger";
+  }
+  // SYSRESETREQ (e.g. a fault handler calling NVIC_SystemReset) sets none of the above
+  return "software reset";
+}
@@ -0,0 +1,42 @@
+#ifndef RESUME_STATE_H
+#define RESUME_STATE_H
+
+#include <Arduino.h>
+
+struct ResumeSnapshot {
+  unsigned long remaining_ms;
+  int default_seconds;
+  bool running;
+  bool alarm_pending;
+  uint8_t heat_percent; // motor heat, rounded up
+  bool motor_tripped;
+};
+
+// Keeps the countdown in the watchdog scratch registers, which survive
+// every reset except power-on/brownout, so a warm boot can pick it up
+// again. Saving is four register writes; nothing touches flash.
+class ResumeState {
+  public:
+    void save(unsigned long remaining_ms, int default_seconds, bool running, bool alarm_pending,
+              uint8_t heat_percent, bool motor_tripped);
+    bool load(ResumeSnapshot& snapshot);
+    void clear();
+
+    static const char* resetReason();
+    static bool wasWatchdogTimeout();
+    // True when the reset also restarted the TIMER, so now() at boot is
+    // the time the reset took
+    static bool timerWasReset();
+
+  private:
+    static const uint32_t MAGIC = 0x52534E4B; // "RSNK"
+    static const uint32_t FLAG_RUNNING = 1UL << 24;
+    static const uint32_t FLAG_ALARM = 1UL << 25;
+    static const int HEAT_SHIFT = 26;          // heat in 31sts of capacity
+    static const uint32_t HEAT_MASK = 0x1FUL << HEAT_SHIFT;
+    static const uint32_t FLAG_TRIPPED = 1UL << 31;
+
+    static uint32_t checksum(uint32_t a, uint32_t b, uint32_t c);
+};
+
+#endif
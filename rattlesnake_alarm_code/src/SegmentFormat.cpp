@@ -0,0 +1,189 @@
+#include "SegmentFormat.h"
+#include "hardware/structs/systick.h"
+
+static constexpr uint8_t DIGIT_SEGMENTS[10] = {
+  0x3f, 0x06, 0x5b, 0x4f, 0x66, 0x6d, 0x7d, 0x07, 0x7f, 0x6f
+};
+
+// Segment bytes of 00-99 as (tens, ones), built by the compiler
+struct DigitPairs {
+  uint8_t digits[100][2];
+
+  constexpr DigitPairs() : digits() {
+    for (int i = 0; i < 100; i++) {
+      digits[i][0] = DIGIT_SEGMENTS[i / 10];
+      digits[i][1] = DIGIT_SEGMENTS[i % 10];
+    }
+  }
+};
+
+static constexpr DigitPairs PAIRS;
+
+// Reciprocal multiplies, each exact below its limit
+static constexpr uint32_t div60(uint32_t x) { return (x * 8739u) >> 19; }          // x < 10082
+static constexpr uint32_t div100(uint32_t x) { return (x * 5243u) >> 19; }         // x < 43690
+static constexpr uint32_t div10(uint32_t x) { return (x * 52429u) >> 19; }         // x < 81920
+static constexpr uint32_t div60Wide(uint32_t x) {                                  // x < 381300
+  return (uint32_t)(((uint64_t)x * 279621u) >> 24);
+}
+static constexpr uint32_t div1000(uint32_t x) {                                    // any x
+  return (uint32_t)(((uint64_t)x * 274877907u) >> 38);
+}
+
+constexpr bool exactBetween(uint32_t (*divide)(uint32_t), uint32_t divisor, uint32_t from, uint32_t to) {
+  for (uint32_t x = from; x < to; x++) {
+    if (divide(x) != x / divisor) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static_assert(exactBetween(div60, 60, 0, 6000), "div60 must cover mm:ss");
+static_assert(exactBetween(div100, 100, 0, 6000), "div100 must cover ss.cc");
+static_assert(exactBetween(div10, 10, 0, 60000), "div10 must cover a minute of ms");
+// Split in two to stay under the compiler's constexpr loop limit
+static_assert(exactBetween(div60Wide, 60, 0, 180000) &&
+              exactBetween(div60Wide, 60, 180000, SegmentFormat::MAX_SECONDS + 1), "div60Wide must cover hh:mm");
+static_assert(exactBetween(div1000, 1000, 0, 100000) &&
+              exactBetween(div1000, 1000, 0xFFFFFFFFu - 100000, 0xFFFFFFFFu), "div1000 must cover 32 bits");
+
+void SegmentFormat::clock(uint32_t seconds, uint8_t segments[4]) {
+  if (seconds < 6000) {
+    minutesSeconds(seconds, segments);
+  } else {
+    hoursMinutes(seconds, segments);
+  }
+}
+
+void SegmentFormat::minutesSeconds(uint32_t seconds, uint8_t segments[4]) {
+  uint32_t minutes = div60(seconds);
+  pair(minutes, seconds - minutes * 60, segments);
+}
+
+void SegmentFormat::hoursMinutes(uint32_t seconds, uint8_t segments[4]) {
+  if (seconds > MAX_SECONDS) {
+    seconds = MAX_SECONDS;
+  }
+  uint32_t minutes = div60Wide(seconds);
+  uint32_t hours = div60(minutes);
+  pair(hours, minutes - hours * 60, segments);
+  // Told apart from mm:ss, which always shows both digits and a steady
+  // colon: the hours drop their leading zero, and the colon is lit on odd
+  // seconds only, so it blinks while running and is dark on a preset
+  if (hours < 10) {
+    segments[0] = 0;
+  }
+  if (!(seconds & 1)) {
+    segments[1] &= ~0x80;
+  }
+}
+
+void SegmentFormat::hundredths(uint32_t ms, uint8_t segments[4]) {
+  uint32_t centis = div10(ms);
+  uint32_t secs = div100(centis);
+  pair(secs, centis - secs * 100, segments);
+}
+
+uint32_t SegmentFormat::floorSeconds(uint32_t ms) {
+  return div1000(ms);
+}
+
+// Whole seconds rounded up, so a 10s countdown starts on 00:10
+uint32_t SegmentFormat::ceilSeconds(uint32_t ms) {
+  uint32_t seconds = div1000(ms);
+  return seconds * 1000 == ms ? seconds : seconds + 1;
+}
+
+void SegmentFormat::pair(uint32_t high, uint32_t low, uint8_t segments[4]) {
+  segments[0] = PAIRS.digits[high][0];
+  segments[1] = PAIRS.digits[high][1] | 0x80; // colon
+  segments[2] = PAIRS.digits[low][0];
+  segments[3] = PAIRS.digits[low][1];
+}
+
+// Division-based rendering as CountdownTimer did it before the table,
+// kept only as the benchmark baseline
+static uint8_t legacyDigit(int value, int position) {
+  int digit = position == 0 ? value % 10 : (value / 10) % 10;
+  return DIGIT_SEGMENTS[digit];
+}
+
+static void legacyMinutesSeconds(uint32_t seconds, uint8_t segments[4]) {
+  int minutes = seconds / 60;
+  int secs = seconds % 60;
+  segments[0] = legacyDigit(minutes, 1);
+  segments[1] = legacyDigit(minutes, 0) | 0x80;
+  segments[2] = legacyDigit(secs, 1);
+  segments[3] = legacyDigit(secs, 0);
+}
+
+static void legacyHundredths(uint32_t ms, uint8_t segments[4]) {
+  int secs = ms / 1000;
+  int centis = (ms % 1000) / 10;
+  segments[0] = legacyDigit(secs, 1);
+  segments[1] = legacyDigit(secs, 0) | 0x80;
+  segments[2] = legacyDigit(centis, 1);
+  segments[3] = legacyDigit(centis, 0);
+}
+
+typedef void (*Renderer)(uint32_t, uint8_t[4]);
+
+static const int BENCH_CALLS_SHIFT = 4; // 16 calls per sample
+static const int BENCH_SAMPLES = 32;
+static volatile uint8_t bench_sink;
+
+// Best of BENCH_SAMPLES, so a tick interrupt landing in one sample is
+// discarded; includes the call and loop overhead, same for both sides
+static uint32_t cyclesPerCall(Renderer render, uint32_t first, uint32_t step) {
+  uint8_t segments[4];
+  uint32_t best = 0xFFFFFFFF;
+  for (int sample = 0; sample < BENCH_SAMPLES; sample++) {
+    uint32_t start = systick_hw->cvr;
+    for (int i = 0; i < (1 << BENCH_CALLS_SHIFT); i++) {
+      render(first + i * step, segments);
+    }
+    uint32_t end = systick_hw->cvr;
+    // Counts down and reloads from rvr
+    uint32_t took = start >= end ? start - end : start + systick_hw->rvr + 1 - end;
+    if (took < best) {
+      best = took;
+    }
+  }
+  bench_sink = segments[3];
+  return best >> BENCH_CALLS_SHIFT;
+}
+
+static void printRow(Print& out, const char* name, Renderer legacy, Renderer table, uint32_t first, uint32_t step) {
+  out.print(name);
+  out.print("  division: ");
+  if (legacy) {
+    out.print(cyclesPerCall(legacy, first, step));
+  } else {
+    out.print('-');
+  }
+  out.print("  table: ");
+  out.println(cyclesPerCall(table, first, step));
+}
+
+void SegmentFormat::printBenchmark(Print& out) {
+  // Borrow SysTick if nothing else runs it; bit 2 selects the core clock
+  bool borrowed = !(systick_hw->csr & 0x1);
+  if (borrowed) {
+    systick_hw->rvr = 0x00FFFFFF;
+    systick_hw->cvr = 0;
+    systick_hw->csr = 0x5;
+  }
+
+  out.println("Cycles per frame (best of 32):");
+  printRow(out, "mm:ss", legacyMinutesSeconds, minutesSeconds, 0, 373);
+  printRow(out, "hh:mm", nullptr, hoursMinutes, 6000, 22111);
+  printRow(out, "ss.cc", legacyHundredths, hundredths, 0, 3733);
+  if (!(systick_hw->csr & 0x4)) {
+    out.println("SysTick runs from the reference clock - figures are ticks, not cycles");
+  }
+
+  if (borrowed) {
+    systick_hw->csr = 0;
+  }
+}
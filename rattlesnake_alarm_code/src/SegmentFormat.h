@@ -0,0 +1,33 @@
+#ifndef SEGMENT_FORMAT_H
+#define SEGMENT_FORMAT_H
+
+#include <Arduino.h>
+
+// Formats times straight into the four TM1637 segment bytes. Digits come
+// from a compile-time table of two-digit pairs and every split is a
+// multiply and shift, so no division is done (the M0+ has no divide
+// instruction). Digit 1 carries the colon.
+class SegmentFormat {
+  public:
+    // mm:ss up to 99:59, hh:mm from 100 minutes on; capped at MAX_SECONDS.
+    // hh:mm blanks a leading zero and lights the colon on odd seconds only.
+    static void clock(uint32_t seconds, uint8_t segments[4]);
+    static void minutesSeconds(uint32_t seconds, uint8_t segments[4]);
+    static void hoursMinutes(uint32_t seconds, uint8_t segments[4]);
+    // ss.cc, for less than a minute
+    static void hundredths(uint32_t ms, uint8_t segments[4]);
+
+    static uint32_t floorSeconds(uint32_t ms);
+    static uint32_t ceilSeconds(uint32_t ms);
+
+    // Cycle counts of the table renderers against the division-based code
+    // they replaced, measured with SysTick
+    static void printBenchmark(Print& out);
+
+    static const uint32_t MAX_SECONDS = 359999; // 99:59 in hh:mm
+
+  private:
+    static void pair(uint32_t high, uint32_t low, uint8_t segments[4]);
+};
+
+#endif
@@ -1,115 +1,213 @@
 #include "SerialCommands.h"
+#include "Timebase.h"
 
-SerialCommands::SerialCommands(CountdownTimer& timer)
+SerialCommands::SerialCommands(Stream& io, CountdownTimer& timer, StateMachine& machine)
   : timer(timer), 
-    serialBuffer(""), 
-    serialCommandReady(false),
-    stopAlarmCallback([]() {}),
-    getAlarmStatusCallback([]() { return false; }),
-    getMotorStatusCallback([]() { return false; }) {}
+    machine(machine),
+    channelCount(0),
+    lineTime(0),
+    extraCommandCount(0) {
+  addChannel(io);
+}
 
-void SerialCommands::update() {
-  readSerial();
-  
-  if (serialCommandReady) {
-    processSerialCommand(serialBuffer);
-    serialBuffer = "";
-    serialCommandReady = false;
+// Handles at most one command per channel per call
+bool SerialCommands::update() {
+  bool handled = false;
+  for (int i = 0; i < channelCount; i++) {
+    Channel& channel = channels[i];
+    readLine(channel);
+    if (channel.commandReady) {
+      lineTime = channel.lineTime;
+      processSerialCommand(String(channel.lineBuffer), *channel.io);
+      channel.lineLength = 0;
+      channel.commandReady = false;
+      handled = true;
+    }
   }
+  return handled;
 }
 
+// The banner goes to the first channel only; other links may be machines
 void SerialCommands::printWelcomeMessage() {
-  Serial.println("Timer Controller Ready");
-  Serial.println("Available commands:");
-  Serial.println("  TIMER_START");
-  Serial.println("  TIMER_STOP");
-  Serial.println("  TIMER_RESET");
-  Serial.println("  STATUS");
-  Serial.println("  SET_TIME <seconds>");
+  Print& io = *channels[0].io;
+  io.println("Timer Controller Ready");
+  io.println("Available commands:");
+  printCommandList(io);
 }
 
-void SerialCommands::setStopAlarmCallback(std::function<void()> callback) {
-  stopAlarmCallback = callback;
+bool SerialCommands::addChannel(Stream& io) {
+  if (channelCount >= MAX_CHANNELS) {
+    return false;
+  }
+  Channel& channel = channels[channelCount++];
+  channel.io = &io;
+  channel.lineBuffer[0] = '\0';
+  channel.lineLength = 0;
+  channel.lineOverflow = false;
+  channel.commandReady = false;
+  channel.lineTime = 0;
+  return true;
 }
 
-void SerialCommands::setAlarmStatusCallback(std::function<bool()> callback) {
-  getAlarmStatusCallback = callback;
+bool SerialCommands::addCommand(const char* name, const char* usage, CommandHandler handler) {
+  if (extraCommandCount >= MAX_EXTRA_COMMANDS) {
+    return false;
+  }
+  extraCommands[extraCommandCount++] = { name, usage, handler };
+  return true;
 }
 
-void SerialCommands::setMotorStatusCallback(std::function<bool()> callback) {
+void SerialCommands::setMotorStatusCallback(Delegate<bool()> callback) {
   getMotorStatusCallback = callback;
 }
 
-void SerialCommands::readSerial() {
-  while (Serial.available()) {
-    char c = Serial.read();
-    
+// Microsecond timestamp of the line terminator of the command being processed
+uint64_t SerialCommands::getLineTime() {
+  return lineTime;
+}
+
+// Reads at most one line per call, so a flooding host gets one command per
+// loop() pass and the rest waits in the transport's buffer. Input is bounded
+// by MAX_LINE_LENGTH; longer lines are dropped whole.
+void SerialCommands::readLine(Channel& channel) {
+  Stream& io = *channel.io;
+  char* lineBuffer = channel.lineBuffer;
+  uint8_t& lineLength = channel.lineLength;
+  bool& lineOverflow = channel.lineOverflow;
+
+  while (!channel.commandReady && io.available()) {
+    int c = io.read();
+    if (c < 0) {
+      break;
+    }
+
     if (c == '\n' || c == '\r') {
-      if (serialBuffer.length() > 0) {
-        serialCommandReady = true;
+      if (lineOverflow) {
+        io.println("Command too long");
+        lineOverflow = false;
+        lineLength = 0;
+      } else if (lineLength > 0) {
+        lineBuffer[lineLength] = '\0';
+        channel.commandReady = true;
+        channel.lineTime = Timebase::now().us;
       }
+    } else if (c < 0x20 || c > 0x7E) {
+      // Control and non-ASCII bytes are never part of a command
+    } else if (lineLength < MAX_LINE_LENGTH) {
+      lineBuffer[lineLength++] = (char)c;
     } else {
-      serialBuffer += c;
+      lineOverflow = true;
     }
   }
 }
 
-void SerialCommands::processSerialCommand(String command) {
+void SerialCommands::processSerialCommand(String command, Print& io) {
   command.trim();
   command.toUpperCase();
   
-  Serial.print("Received command: ");
-  Serial.println(command);
+  io.print("Received command: ");
+  io.println(command);
   
   if (command == "TIMER_START") {
-    bool alarmActive = getAlarmStatusCallback();
-    if (alarmActive) {
-      Serial.println("Cannot start timer - alarm is active");
-    } else if (timer.isRunning()) {
-      Serial.println("Timer is already running");
+    State state = machine.getState();
+    if (state == STATE_ALARMING) {
+      io.println("Cannot start timer - alarm is active");
+    } else if (state == STATE_RUNNING) {
+      io.println("Timer is already running");
+    } else if (timer.getRemainingTime() <= 0) {
+      io.println("Cannot start timer - time is zero");
+    } else if (machine.dispatch(EVENT_START)) {
+      io.println("Timer started via serial command");
     } else {
-      timer.start();
-      Serial.println("Timer started via serial command");
+      io.print("Cannot start timer - state is ");
+      io.println(StateMachine::stateName(state));
     }
   }
   else if (command == "TIMER_STOP" || command == "TIMER_RESET") {
-    bool alarmActive = getAlarmStatusCallback();
-    if (alarmActive) {
-      stopAlarmCallback();
-      Serial.println("Alarm stopped via serial command");
+    bool alarmActive = machine.getState() == STATE_ALARMING;
+    if (machine.dispatch(EVENT_STOP)) {
+      io.println(alarmActive ? "Alarm stopped via serial command" : "Timer reset via serial command");
     } else {
       timer.reset();
-      Serial.println("Timer reset via serial command");
+      io.println("Timer reset via serial command");
     }
   }
   else if (command == "STATUS") {
-    Serial.print("Timer running: ");
-    Serial.println(timer.isRunning());
-    Serial.print("Remaining time: ");
-    Serial.println(timer.getRemainingTime());
-    Serial.print("Alarm active: ");
-    Serial.println(getAlarmStatusCallback());
-    Serial.print("Motor started: ");
-    Serial.println(getMotorStatusCallback());
+    io.print("Timer running: ");
+    io.println(timer.isRunning());
+    io.print("Remaining time: ");
+    io.println(timer.getRemainingTime());
+    io.print("Alarm active: ");
+    io.println(machine.getState() == STATE_ALARMING);
+    io.print("Motor started: ");
+    io.println(getMotorStatusCallback());
+    io.print("State: ");
+    io.println(StateMachine::stateName(machine.getState()));
+    io.print("Transitions: ");
+    io.println(machine.getTransitionCount());
   }
   else if (command.startsWith("SET_TIME ")) {
-    int seconds = command.substring(9).toInt();
-    bool alarmActive = getAlarmStatusCallback();
-    if (seconds > 0 && !timer.isRunning() && !alarmActive) {
+    int seconds;
+    if (!parseSeconds(command.substring(9), seconds)) {
+      io.println("Invalid time - expected whole seconds from 1 to 359999");
+    } else if (machine.dispatch(EVENT_EDIT)) {
       timer.setTime(seconds);
-      Serial.print("Timer set to ");
-      Serial.print(seconds);
-      Serial.println(" seconds");
+      io.print("Timer set to ");
+      io.print(seconds);
+      io.println(" seconds");
     } else {
-      Serial.println("Cannot set time - timer is running or alarm is active");
+      io.println("Cannot set time - timer is running or alarm is active");
     }
   }
-  else {
-    Serial.println("Unknown command. Available commands:");
-    Serial.println("  TIMER_START");
-    Serial.println("  TIMER_STOP");
-    Serial.println("  TIMER_RESET");
-    Serial.println("  STATUS");
-    Serial.println("  SET_TIME <seconds>");
+  else if (!processExtraCommand(command, io)) {
+    io.println("Unknown command. Available commands:");
+    printCommandList(io);
+  }
+}
+
+bool SerialCommands::parseSeconds(const String& text, int& seconds) {
+  const char* start = text.c_str();
+  char* end;
+  long value = strtol(start, &end, 10);
+  while (*end == ' ') {
+    end++;
+  }
+  if (end == start || *end != '\0' || value < 1 || value > 359999) {
+    return false;
+  }
+  seconds = (int)value;
+  return true;
+}
+
+bool SerialCommands::processExtraCommand(const String& command, Print& io) {
+  for (int i = 0; i < extraCommandCount; i++) {
+    const ExtraCommand& entry = extraCommands[i];
+    size_t len = strlen(entry.name);
+    if (!command.startsWith(entry.name)) {
+      continue;
+    }
+    if (command.length() == len) {
+      entry.handler(String(""), io);
+      return true;
+    }
+    if (command.charAt(len) == ' ') {
+      String args = command.substring(len + 1);
+      args.trim();
+      entry.handler(args, io);
+      return true;
+    }
+  }
+  return false;
+}
+
+void SerialCommands::printCommandList(Print& io) {
+  io.println("  TIMER_START");
+  io.println("  TIMER_STOP");
+  io.println("  TIMER_RESET");
+  io.println("  STATUS");
+  io.println("  SET_TIME <seconds>");
+  for (int i = 0; i < extraCommandCount; i++) {
+    io.print("  ");
+    io.println(extraCommands[i].usage);
   }
 }
\ No newline at end of file
@@ -3,30 +3,63 @@
 
 #include <Arduino.h>
 #include "CountdownTimer.h"
+#include "StateMachine.h"
+#include "Delegate.h"
 
+// Handler for a command registered by another module; args is the text
+// after the command name (already trimmed and upper-cased)
+typedef Delegate<void(const String& args, Print& out)> CommandHandler;
+
+// Command interpreter shared by any number of transports (channels). Each
+// channel has its own line buffer and gets the responses to its commands;
+// the command table is common to all of them.
 class SerialCommands {
   public:
-    SerialCommands(CountdownTimer& timer);
+    SerialCommands(Stream& io, CountdownTimer& timer, StateMachine& machine);
     
-    void update();
+    bool update();
     void printWelcomeMessage();
+    bool addCommand(const char* name, const char* usage, CommandHandler handler);
+    bool addChannel(Stream& io);
+    uint64_t getLineTime();
     
     // Function pointers for external callbacks
-    void setStopAlarmCallback(std::function<void()> callback);
-    void setAlarmStatusCallback(std::function<bool()> callback);
-    void setMotorStatusCallback(std::function<bool()> callback);
+    void setMotorStatusCallback(Delegate<bool()> callback);
 
   private:
+    struct ExtraCommand {
+      const char* name;
+      const char* usage;
+      CommandHandler handler;
+    };
+    static const int MAX_EXTRA_COMMANDS = 32;
+    static const int MAX_CHANNELS = 4;
+    static const uint8_t MAX_LINE_LENGTH = 96;
+
+    struct Channel {
+      Stream* io;
+      char lineBuffer[MAX_LINE_LENGTH + 1];
+      uint8_t lineLength;
+      bool lineOverflow;
+      bool commandReady;
+      uint64_t lineTime;
+    };
+
     CountdownTimer& timer;
-    String serialBuffer;
-    bool serialCommandReady;
+    StateMachine& machine;
+    Channel channels[MAX_CHANNELS];
+    int channelCount;
+    uint64_t lineTime;
     
-    std::function<void()> stopAlarmCallback;
-    std::function<bool()> getAlarmStatusCallback;
-    std::function<bool()> getMotorStatusCallback;
+    Delegate<bool()> getMotorStatusCallback;
+    ExtraCommand extraCommands[MAX_EXTRA_COMMANDS];
+    int extraCommandCount;
     
-    void readSerial();
-    void processSerialCommand(String command);
+    void readLine(Channel& channel);
+    void processSerialCommand(String command, Print& io);
+    bool processExtraCommand(const String& command, Print& io);
+    static bool parseSeconds(const String& text, int& seconds);
+    void printCommandList(Print& io);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,89 @@
+#include "StateMachine.h"
+
+// Next state for every (state, event) pair; STATE_COUNT means the event is
+// not allowed in that state and is ignored.
+static constexpr State NONE = STATE_COUNT;
+
+static constexpr State transitions[STATE_COUNT][EVENT_COUNT] = {
+  //                 EDIT           EDIT_DONE   START          STOP        FINISHED        ALARM_DONE  FAULT        ALARM           STOPWATCH
+  /* IDLE      */ { STATE_EDITING, NONE,       STATE_RUNNING, NONE,       NONE,           NONE,       STATE_FAULT, STATE_ALARMING, STATE_STOPWATCH },
+  /* EDITING   */ { STATE_EDITING, STATE_IDLE, STATE_RUNNING, NONE,       NONE,           NONE,       STATE_FAULT, STATE_ALARMING, STATE_STOPWATCH },
+  /* RUNNING   */ { NONE,          NONE,       NONE,          STATE_IDLE, STATE_ALARMING, NONE,       STATE_FAULT, NONE,           NONE            },
+  /* ALARMING  */ { NONE,          NONE,       NONE,          STATE_IDLE, NONE,           STATE_IDLE, STATE_FAULT, NONE,           NONE            },
+  /* FAULT     */ { NONE,          NONE,       NONE,          STATE_IDLE, NONE,           NONE,       NONE,        NONE,           NONE            },
+  /* STOPWATCH */ { NONE,          NONE,       NONE,          STATE_IDLE, NONE,           NONE,       STATE_FAULT, NONE,           NONE            },
+};
+
+static const char* const stateNames[STATE_COUNT] = {
+  "IDLE", "EDITING", "RUNNING", "ALARMING", "FAULT", "STOPWATCH"
+};
+
+StateMachine::StateMachine()
+  : state(STATE_IDLE),
+    transition_count(0),
+    last_event_time{0},
+    in_transition(false) {
+  for (int i = 0; i < STATE_COUNT; i++) {
+    actions[i] = { nullptr, nullptr, nullptr };
+  }
+}
+
+void StateMachine::setActions(State s, void (*onEnter)(), void (*onExit)(), void (*onTick)()) {
+  actions[s] = { onEnter, onExit, onTick };
+}
+
+bool StateMachine::dispatch(Event event) {
+  // Events raised from inside an entry/exit action are rejected so a
+  // transition always completes before the next one starts.
+  if (in_transition) {
+    return false;
+  }
+
+  State next = transitions[state][event];
+  if (next == NONE) {
+    return false;
+  }
+
+  last_event_time = Timebase::now();
+  if (next == state) {
+    return true;
+  }
+
+  in_transition = true;
+  if (actions[state].onExit) {
+    actions[state].onExit();
+  }
+  state = next;
+  transition_count++;
+  if (actions[state].onEnter) {
+    actions[state].onEnter();
+  }
+  in_transition = false;
+  return true;
+}
+
+bool StateMachine::accepts(Event event) {
+  return transitions[state][event] != NONE;
+}
+
+void StateMachine::tick() {
+  if (actions[state].onTick) {
+    actions[state].onTick();
+  }
+}
+
+State StateMachine::getState() {
+  return state;
+}
+
+unsigned long StateMachine::getTransitionCount() {
+  return transition_count;
+}
+
+Instant StateMachine::getLastEventTime() {
+  return last_event_time;
+}
+
+const char* StateMachine::stateName(State s) {
+  return s < STATE_COUNT ? stateNames[s] : "UNKNOWN";
+}
\ No newline at end of file
@@ -0,0 +1,59 @@
+#ifndef STATE_MACHINE_H
+#define STATE_MACHINE_H
+
+#include <Arduino.h>
+#include "Timebase.h"
+
+enum State {
+  STATE_IDLE,
+  STATE_EDITING,
+  STATE_RUNNING,
+  STATE_ALARMING,
+  STATE_FAULT,
+  STATE_STOPWATCH,
+  STATE_COUNT
+};
+
+enum Event {
+  EVENT_EDIT,       // preset changed (encoder, mode toggle, SET_TIME)
+  EVENT_EDIT_DONE,  // no edits for a while
+  EVENT_START,
+  EVENT_STOP,
+  EVENT_FINISHED,   // countdown reached zero
+  EVENT_ALARM_DONE, // alarm ran for its full duration
+  EVENT_FAULT,      // safety limit tripped
+  EVENT_ALARM,      // alarm requested outside a countdown (wall clock, resume)
+  EVENT_STOPWATCH,  // count up instead of down
+  EVENT_COUNT
+};
+
+// Entry/exit actions run on a state change, tick runs once per loop() pass
+struct StateActions {
+  void (*onEnter)();
+  void (*onExit)();
+  void (*onTick)();
+};
+
+class StateMachine {
+  public:
+    StateMachine();
+
+    void setActions(State state, void (*onEnter)(), void (*onExit)(), void (*onTick)());
+    bool dispatch(Event event);
+    bool accepts(Event event);
+    void tick();
+
+    State getState();
+    unsigned long getTransitionCount();
+    Instant getLastEventTime();
+    static const char* stateName(State state);
+
+  private:
+    State state;
+    unsigned long transition_count;
+    Instant last_event_time;
+    bool in_transition;
+    StateActions actions[STATE_COUNT];
+};
+
+#endif
\ No newline at end of file
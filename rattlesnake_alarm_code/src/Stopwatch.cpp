@@ -0,0 +1,170 @@
+#include "Stopwatch.h"
+#include "SegmentFormat.h"
+#include "Switch.h"
+
+// Under a minute the display shows ss.cc, refreshed at this interval
+static const unsigned long HUNDREDTHS_INTERVAL = 50; // ms
+
+Stopwatch::Stopwatch(MirroredDisplay& display)
+  : display(display),
+    running(false),
+    start_time{0},
+    stop_time{0},
+    last_edge{0},
+    press_time{0},
+    press_pending(false),
+    dropped_lap{0},
+    lap_count(0),
+    last_render{0} {}
+
+void Stopwatch::start() {
+  noInterrupts();
+  start_time = Timebase::now();
+  last_edge = start_time;
+  press_pending = false;
+  lap_count = 0;
+  running = true;
+  interrupts();
+  render(Duration{0});
+}
+
+void Stopwatch::stop() {
+  if (running) {
+    stop_time = Timebase::now();
+    running = false;
+    render(stop_time - start_time);
+  }
+}
+
+void Stopwatch::update() {
+  if (!running) {
+    return;
+  }
+  Instant now = Timebase::now();
+  if (now - start_time < Duration::fromSeconds(60) &&
+      now - last_render < Duration::fromMillis(HUNDREDTHS_INTERVAL)) {
+    return;
+  }
+  render(now - start_time);
+}
+
+void Stopwatch::noteEdge(bool pressed) {
+  Instant now = Timebase::now();
+  bool settled = now - last_edge >= Duration::fromMillis(EDGE_SETTLE_TIME);
+  last_edge = now;
+  if (!settled) {
+    return;
+  }
+  if (pressed) {
+    press_time = now;
+    press_pending = true;
+  } else if (press_pending) {
+    press_pending = false;
+    if (now - press_time < Duration::fromMillis(Switch::long_press_time)) {
+      lap(press_time);
+    }
+  }
+}
+
+void Stopwatch::lap(Instant at) {
+  if (!running) {
+    return;
+  }
+  // Oldest laps are overwritten once the buffer is full; the last one
+  // dropped is kept so the first remaining split stays correct
+  Instant& slot = laps[lap_count % MAX_LAPS];
+  if (lap_count >= (unsigned long)MAX_LAPS) {
+    dropped_lap = slot;
+  }
+  slot = at;
+  lap_count = lap_count + 1;
+}
+
+bool Stopwatch::isRunning() {
+  return running;
+}
+
+Duration Stopwatch::getElapsed() {
+  return (running ? Timebase::now() : stop_time) - start_time;
+}
+
+unsigned long Stopwatch::getLapCount() {
+  return lap_count;
+}
+
+// One block: a header, one "<n> <elapsed> <split>" line per lap, END.
+// Times are milliseconds with microsecond decimals.
+void Stopwatch::printLaps(Print& out) {
+  noInterrupts();
+  unsigned long count = lap_count;
+  interrupts();
+
+  unsigned long first = count > (unsigned long)MAX_LAPS ? count - MAX_LAPS : 0;
+  out.print("LAPS ");
+  out.print(count - first);
+  out.print(' ');
+  printMillis(out, getElapsed());
+  if (first > 0) {
+    out.print(" (");
+    out.print(first);
+    out.print(" overwritten)");
+  }
+  out.println();
+
+  Instant previous = first > 0 ? dropped_lap : start_time;
+  for (unsigned long n = first; n < count; n++) {
+    Instant at = laps[n % MAX_LAPS];
+    out.print(n + 1);
+    out.print(' ');
+    printMillis(out, at - start_time);
+    out.print(' ');
+    printMillis(out, at - previous);
+    out.println();
+    previous = at;
+  }
+  out.println("END");
+}
+
+// ss.cc for the first minute, then mm:ss, then hh:mm; writeFrame() only
+// sends the digits that differ from what is shown
+void Stopwatch::render(Duration elapsed) {
+  int64_t ms = elapsed.toMillis();
+  uint8_t segments[4];
+  if (ms < 60000) {
+    SegmentFormat::hundredths(ms, segments);
+  } else {
+    SegmentFormat::clock(SegmentFormat::floorSeconds(ms < 0xFFFFFFFF ? ms : 0xFFFFFFFF), segments);
+  }
+  last_render = Timebase::now();
+  writeFrame(segments);
+}
+
+void Stopwatch::writeFrame(const uint8_t segments[4]) {
+  uint8_t shown[4];
+  display.getFrame(shown);
+
+  int first = 0;
+  int last = 3;
+  while (first <= last && segments[first] == shown[first]) {
+    first++;
+  }
+  while (last >= first && segments[last] == shown[last]) {
+    last--;
+  }
+  if (first <= last) {
+    display.setSegments(&segments[first], last - first + 1, first);
+  }
+}
+
+void Stopwatch::printMillis(Print& out, Duration d) {
+  unsigned long us = d.us % 1000;
+  out.print((unsigned long)d.toMillis());
+  out.print('.');
+  if (us < 100) {
+    out.print('0');
+  }
+  if (us < 10) {
+    out.print('0');
+  }
+  out.print(us);
+}
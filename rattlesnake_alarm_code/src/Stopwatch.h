@@ -0,0 +1,51 @@
+#ifndef STOPWATCH_H
+#define STOPWATCH_H
+
+#include <Arduino.h>
+#include "MirroredDisplay.h"
+#include "Timebase.h"
+
+// Count-up timer with lap capture. Laps go into a fixed ring buffer and are
+// only read back in bulk; recording one is a timestamp and a store, cheap
+// enough to do from the switch edge interrupt.
+class Stopwatch {
+  public:
+    Stopwatch(MirroredDisplay& display);
+
+    void start();
+    void stop();
+    void update();
+
+    // Called from the switch edge interrupt for both edges. A press that
+    // follows a quiet line is timestamped and becomes a lap on release,
+    // unless it was held long enough to be the long press that stops us.
+    void noteEdge(bool pressed);
+    void lap(Instant at);
+
+    bool isRunning();
+    Duration getElapsed();
+    unsigned long getLapCount();
+    void printLaps(Print& out);
+
+    static const int MAX_LAPS = 64;
+    static const unsigned long EDGE_SETTLE_TIME = 30; // ms
+
+  private:
+    MirroredDisplay& display;
+    volatile bool running;
+    Instant start_time;
+    Instant stop_time;
+    Instant last_edge;
+    Instant press_time;
+    bool press_pending;
+    Instant laps[MAX_LAPS];
+    Instant dropped_lap;
+    volatile unsigned long lap_count; // total recorded, including overwritten
+    Instant last_render;
+
+    void render(Duration elapsed);
+    void writeFrame(const uint8_t segments[4]);
+    static void printMillis(Print& out, Duration d);
+};
+
+#endif
@@ -4,23 +4,21 @@ Switch::Switch(uint8_t pin)
   : pin(pin), 
     state(false), 
     last_state(false),
-    last_debounce_time(0), 
-    press_start(0), 
-    long_press_reported(false),
-    onShortPress([]() {}),
-    onLongPress([]() {}) {
+    last_debounce_time{0}, 
+    press_start{0}, 
+    long_press_reported(false) {
   pinMode(pin, INPUT_PULLUP);
 }
 
 void Switch::update() {
   bool reading = digitalRead(pin) == LOW;
-  unsigned long now = millis();
+  Instant now = Timebase::now();
 
   if (reading != last_state) {
     last_debounce_time = now;
   }
 
-  if ((now - last_debounce_time) > debounce_delay) {
+  if ((now - last_debounce_time) > Duration::fromMillis(debounce_delay)) {
     if (reading != state) {
       state = reading;
 
@@ -28,8 +26,8 @@ void Switch::update() {
         press_start = now;
         long_press_reported = false;
       } else {
-        unsigned long press_duration = now - press_start;
-        if (press_duration >= long_press_time) {
+        Duration press_duration = now - press_start;
+        if (press_duration >= Duration::fromMillis(long_press_time)) {
           onLongPress();
         } else {
           onShortPress();
@@ -41,7 +39,7 @@ void Switch::update() {
   last_state = reading;
 }
 
-void Switch::setHandlers(std::function<void()> shortPressFunc, std::function<void()> longPressFunc) {
+void Switch::setHandlers(Delegate<void()> shortPressFunc, Delegate<void()> longPressFunc) {
   onShortPress = shortPressFunc;
   onLongPress = longPressFunc;
 }
\ No newline at end of file
@@ -0,0 +1,86 @@
+#include "SyncLine.h"
+#include "hardware/gpio.h"
+
+SyncLine* SyncLine::instance = nullptr;
+
+SyncLine::SyncLine(uint8_t pin)
+  : pin(pin),
+    armed(false),
+    fire_time{0},
+    edge_time{0},
+    start_time{0},
+    started(false),
+    edge_count(0) {}
+
+// The output latch stays at 0; driving the line is only a direction change.
+// gpio_init() hands the pin to SIO, since attachInterrupt() leaves its
+// function alone and the direction and latch writes act only through SIO.
+void SyncLine::begin() {
+  instance = this;
+  attachInterrupt(digitalPinToInterrupt(pin), onEdge, FALLING);
+  gpio_init(pin);
+  gpio_put(pin, 0);
+  gpio_set_dir(pin, GPIO_IN);
+  gpio_pull_up(pin);
+}
+
+void SyncLine::arm(Delegate<bool(Instant)> onEdge) {
+  noInterrupts();
+  handler = onEdge;
+  armed = true;
+  interrupts();
+}
+
+void SyncLine::disarm() {
+  armed = false;
+}
+
+bool SyncLine::isArmed() {
+  return armed;
+}
+
+void SyncLine::fire() {
+  fire_time = Timebase::now();
+  gpio_set_dir(pin, GPIO_OUT);
+  delayMicroseconds(PULSE_US);
+  gpio_set_dir(pin, GPIO_IN);
+}
+
+void SyncLine::printStatus(Print& out) {
+  out.print("Sync: ");
+  out.print(armed ? "armed" : "disarmed");
+  out.print(", line ");
+  out.println(gpio_get(pin) ? "high" : "low");
+
+  if (edge_count == 0) {
+    out.println("No edge received while armed");
+    return;
+  }
+  out.print("Edges: ");
+  out.print(edge_count);
+  out.print(", last ");
+  out.println(started ? "timer started" : "ignored, timer was busy");
+  out.print("Edge to start: ");
+  out.print((unsigned long)(start_time - edge_time).us);
+  out.println("us");
+  // Only when this clock pulled the line for the last edge
+  Duration since_fire = edge_time - fire_time;
+  if (fire_time.us != 0 && since_fire >= Duration{0} && since_fire < Duration::fromMicros(PULSE_US)) {
+    out.print("Pull to edge interrupt: ");
+    out.print((unsigned long)(edge_time - fire_time).us);
+    out.println("us");
+  }
+}
+
+void SyncLine::onEdge() {
+  Instant now = Timebase::now();
+  SyncLine* line = instance;
+  if (!line || !line->armed) {
+    return;
+  }
+  line->armed = false;
+  line->edge_time = now;
+  line->started = line->handler(now);
+  line->start_time = Timebase::now();
+  line->edge_count++;
+}
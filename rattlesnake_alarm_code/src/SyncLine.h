@@ -0,0 +1,43 @@
+#ifndef SYNC_LINE_H
+#define SYNC_LINE_H
+
+#include <Arduino.h>
+#include "Delegate.h"
+#include "Timebase.h"
+
+// Shared open-drain trigger line for starting several clocks together.
+// Every clock only ever pulls the line low or lets it float, so any of them
+// (or the host) can fire it. An armed clock timestamps the falling edge as
+// the first thing in its interrupt and hands that instant to the handler,
+// so all clocks start from the same physical edge. Arming is one-shot.
+class SyncLine {
+  public:
+    SyncLine(uint8_t pin);
+
+    void begin();
+    // The handler runs in interrupt context and returns whether it started
+    void arm(Delegate<bool(Instant)> onEdge);
+    void disarm();
+    bool isArmed();
+    // Pulls the line low for PULSE_US
+    void fire();
+
+    void printStatus(Print& out);
+
+    static const unsigned int PULSE_US = 100;
+
+  private:
+    uint8_t pin;
+    volatile bool armed;
+    Delegate<bool(Instant)> handler;
+    Instant fire_time;        // when this clock last pulled the line
+    Instant edge_time;        // interrupt entry on the last armed edge
+    Instant start_time;       // handler return on the last armed edge
+    volatile bool started;
+    unsigned long edge_count;
+
+    static SyncLine* instance;
+    static void onEdge();
+};
+
+#endif
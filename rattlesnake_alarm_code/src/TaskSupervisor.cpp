@@ -0,0 +1,153 @@
+#include "TaskSupervisor.h"
+#include "hardware/timer.h"
+#include "hardware/watchdog.h"
+
+void (*TaskSupervisor::stall_handler)() = nullptr;
+volatile bool TaskSupervisor::stalled = false;
+
+TaskSupervisor::TaskSupervisor()
+  : task_count(0),
+    pass_ok(true),
+    skipped_feeds(0),
+    last_overrun_task(-1),
+    last_overrun_us(0),
+    last_overrun_time{0},
+    pause_start{0},
+    paused{0},
+    watchdog_running(false),
+    watchdog_timeout(0),
+    stall_alarm(-1) {}
+
+// Returns -1 once the table is full; run() ignores an invalid id's budget
+TaskId TaskSupervisor::addTask(const char* name, unsigned long budget_us, bool critical) {
+  if (task_count >= MAX_TASKS) {
+    return -1;
+  }
+  tasks[task_count] = { name, budget_us, critical, 0, 0, 0, 0 };
+  return task_count++;
+}
+
+void TaskSupervisor::run(TaskId id, Delegate<void()> job) {
+  paused = Duration{0};
+  Instant start = Timebase::now();
+  job();
+  if (id < 0 || id >= task_count) {
+    return;
+  }
+
+  TaskStats& task = tasks[id];
+  unsigned long took = (Timebase::now() - start - paused).us;
+  task.runs++;
+  task.last_us = took;
+  if (took > task.worst_us) {
+    task.worst_us = took;
+  }
+  if (took > task.budget_us) {
+    task.overruns++;
+    last_overrun_task = id;
+    last_overrun_us = took;
+    last_overrun_time = start;
+    if (task.critical) {
+      pass_ok = false;
+    }
+  }
+}
+
+// Called once at the end of every loop() pass
+void TaskSupervisor::endPass() {
+  if (watchdog_running) {
+    if (pass_ok && !stalled) {
+      feed();
+    } else {
+      skipped_feeds++;
+    }
+  }
+  pass_ok = true;
+}
+
+void TaskSupervisor::startWatchdog(unsigned long timeout_ms, void (*onStall)()) {
+  stall_handler = onStall;
+  watchdog_timeout = timeout_ms;
+  stall_alarm = hardware_alarm_claim_unused(false);
+  if (stall_alarm >= 0) {
+    hardware_alarm_set_callback(stall_alarm, onStallAlarm);
+  }
+  watchdog_enable(timeout_ms, true);
+  watchdog_running = true;
+  feed();
+}
+
+void TaskSupervisor::pause() {
+  pause_start = Timebase::now();
+  if (watchdog_running) {
+    hw_clear_bits(&watchdog_hw->ctrl, WATCHDOG_CTRL_ENABLE_BITS);
+    if (stall_alarm >= 0) {
+      hardware_alarm_cancel(stall_alarm);
+    }
+  }
+}
+
+void TaskSupervisor::resume() {
+  paused = paused + (Timebase::now() - pause_start);
+  if (watchdog_running) {
+    watchdog_update();
+    hw_set_bits(&watchdog_hw->ctrl, WATCHDOG_CTRL_ENABLE_BITS);
+    feed();
+  }
+}
+
+void TaskSupervisor::printStatus(Print& out) {
+  out.println("Task      Budget(us)  Last(us)  Worst(us)  Overruns  Runs");
+  for (int i = 0; i < task_count; i++) {
+    const TaskStats& task = tasks[i];
+    out.print(task.name);
+    for (size_t pad = strlen(task.name); pad < 8; pad++) {
+      out.print(' ');
+    }
+    out.print(task.critical ? "* " : "  ");
+    out.print(task.budget_us);
+    out.print("  ");
+    out.print(task.last_us);
+    out.print("  ");
+    out.print(task.worst_us);
+    out.print("  ");
+    out.print(task.overruns);
+    out.print("  ");
+    out.println(task.runs);
+  }
+  if (last_overrun_task >= 0) {
+    out.print("Last overrun: ");
+    out.print(tasks[last_overrun_task].name);
+    out.print(' ');
+    out.print(last_overrun_us);
+    out.print("us at ");
+    out.print((unsigned long)last_overrun_time.toMillis());
+    out.println("ms");
+  }
+  out.print("Watchdog: ");
+  if (watchdog_running) {
+    out.print(watchdog_timeout);
+    out.print("ms, feeds skipped: ");
+    out.println(skipped_feeds);
+  } else {
+    out.println("off");
+  }
+  out.println("* = critical, feeds the watchdog only when within budget");
+}
+
+void TaskSupervisor::feed() {
+  watchdog_update();
+  if (stall_alarm >= 0) {
+    uint64_t at = Timebase::now().us + (uint64_t)(watchdog_timeout - STALL_MARGIN_MS) * 1000;
+    hardware_alarm_set_target(stall_alarm, from_us_since_boot(at));
+  }
+}
+
+// Nothing has fed the watchdog for timeout - margin. The flag stops any
+// later feed, so the reset still happens even if loop() comes back.
+void TaskSupervisor::onStallAlarm(unsigned int alarm_num) {
+  stalled = true;
+  if (stall_handler) {
+    stall_handler();
+  }
+}
@@ -0,0 +1,66 @@
+#ifndef TASK_SUPERVISOR_H
+#define TASK_SUPERVISOR_H
+
+#include <Arduino.h>
+#include "Delegate.h"
+#include "Timebase.h"
+
+typedef int TaskId;
+
+struct TaskStats {
+  const char* name;
+  unsigned long budget_us;
+  bool critical;
+  unsigned long runs;
+  unsigned long overruns;
+  unsigned long last_us;
+  unsigned long worst_us;
+};
+
+// Runs the periodic jobs of loop() against a time budget each and feeds the
+// hardware watchdog only after a pass in which every critical job met its
+// budget. A hardware alarm set just short of the watchdog timeout calls the
+// stall handler from interrupt context, so outputs can be made safe before
+// the chip resets.
+class TaskSupervisor {
+  public:
+    TaskSupervisor();
+
+    TaskId addTask(const char* name, unsigned long budget_us, bool critical);
+    void run(TaskId id, Delegate<void()> job);
+    void endPass();
+
+    void startWatchdog(unsigned long timeout_ms, void (*onStall)());
+    // Time between pause() and resume() is not charged to the running job
+    // and the watchdog is stopped, e.g. while dormant
+    void pause();
+    void resume();
+
+    void printStatus(Print& out);
+
+    static const int MAX_TASKS = 12;
+    // Lead time of the stall handler over the watchdog reset
+    static const unsigned long STALL_MARGIN_MS = 200;
+
+  private:
+    TaskStats tasks[MAX_TASKS];
+    int task_count;
+    bool pass_ok;
+    unsigned long skipped_feeds;
+    TaskId last_overrun_task;
+    unsigned long last_overrun_us;
+    Instant last_overrun_time;
+    Instant pause_start;
+    Duration paused;
+    bool watchdog_running;
+    unsigned long watchdog_timeout;
+    int stall_alarm;
+
+    static void (*stall_handler)();
+    static volatile bool stalled;
+
+    void feed();
+    static void onStallAlarm(unsigned int alarm_num);
+};
+
+#endif
@@ -0,0 +1,13 @@
+#include "Timebase.h"
+#include "hardware/timer.h"
+
+TimeSource* Timebase::source = nullptr;
+
+Instant Timebase::now() {
+  return Instant{source ? source->nowMicros() : time_us_64()};
+}
+
+// nullptr restores the hardware timer
+void Timebase::setSource(TimeSource* newSource) {
+  source = newSource;
+}
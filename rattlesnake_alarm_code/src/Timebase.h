@@ -0,0 +1,65 @@
+#ifndef TIMEBASE_H
+#define TIMEBASE_H
+
+#include <Arduino.h>
+
+// Signed span of time in microseconds
+struct Duration {
+  int64_t us;
+
+  static constexpr Duration fromMicros(int64_t value) { return Duration{value}; }
+  static constexpr Duration fromMillis(int64_t value) { return Duration{value * 1000}; }
+  static constexpr Duration fromSeconds(int64_t value) { return Duration{value * 1000000}; }
+
+  constexpr int64_t toMillis() const { return us / 1000; }
+
+  constexpr Duration operator+(Duration other) const { return Duration{us + other.us}; }
+  constexpr Duration operator-(Duration other) const { return Duration{us - other.us}; }
+  constexpr bool operator<(Duration other) const { return us < other.us; }
+  constexpr bool operator<=(Duration other) const { return us <= other.us; }
+  constexpr bool operator>(Duration other) const { return us > other.us; }
+  constexpr bool operator>=(Duration other) const { return us >= other.us; }
+  constexpr bool operator==(Duration other) const { return us == other.us; }
+};
+
+// Point on the 64-bit microsecond timeline that starts at reset; it would
+// take over 500,000 years to wrap, so plain subtraction is always safe
+struct Instant {
+  uint64_t us;
+
+  constexpr Instant operator+(Duration d) const { return Instant{us + d.us}; }
+  constexpr Instant operator-(Duration d) const { return Instant{us - d.us}; }
+  constexpr Duration operator-(Instant other) const { return Duration{(int64_t)(us - other.us)}; }
+  constexpr bool operator<(Instant other) const { return us < other.us; }
+  constexpr bool operator>=(Instant other) const { return us >= other.us; }
+  constexpr bool operator==(Instant other) const { return us == other.us; }
+  constexpr uint64_t toMillis() const { return us / 1000; }
+};
+
+// Instant something is due, with the questions callers ask of it
+struct Deadline {
+  Instant at;
+
+  static constexpr Deadline after(Instant now, Duration d) { return Deadline{now + d}; }
+  constexpr bool expired(Instant now) const { return now >= at; }
+  constexpr Duration remaining(Instant now) const { return now >= at ? Duration{0} : at - now; }
+};
+
+// Where the time comes from; host builds and tests install their own
+class TimeSource {
+  public:
+    virtual uint64_t nowMicros() = 0;
+    virtual ~TimeSource() {}
+};
+
+// Single clock shared by every module, backed by the RP2040 64-bit timer
+class Timebase {
+  public:
+    static Instant now();
+    static void setSource(TimeSource* source);
+
+  private:
+    static TimeSource* source;
+};
+
+#endif
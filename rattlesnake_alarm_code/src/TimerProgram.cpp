@@ -0,0 +1,172 @@
+#include "TimerProgram.h"
+
+TimerProgram::TimerProgram()
+  : step_count(0),
+    position(0),
+    repetition(0),
+    active(false),
+    paused(false),
+    pending(false),
+    in_step(false) {}
+
+// Parses "<seconds>:<pattern>[:<repeat>],..." where pattern is A (alarm),
+// D (display only) or S (silent). The current program is kept on error.
+bool TimerProgram::load(const String& text) {
+  ProgramStep parsed[MAX_STEPS];
+  uint8_t count = 0;
+  const char* p = text.c_str();
+
+  while (*p) {
+    if (count >= MAX_STEPS) {
+      return false;
+    }
+
+    char* end;
+    unsigned long seconds = strtoul(p, &end, 10);
+    if (end == p || *end != ':' || seconds == 0 || seconds > 0xFFFF) {
+      return false;
+    }
+    p = end + 1;
+
+    uint8_t pattern;
+    switch (*p++) {
+      case 'A': pattern = PATTERN_ALARM; break;
+      case 'D': pattern = PATTERN_DISPLAY; break;
+      case 'S': pattern = PATTERN_SILENT; break;
+      default: return false;
+    }
+
+    unsigned long repeat = 1;
+    if (*p == ':') {
+      p++;
+      repeat = strtoul(p, &end, 10);
+      if (end == p || repeat == 0 || repeat > 0xFF) {
+        return false;
+      }
+      p = end;
+    }
+
+    if (*p == ',') {
+      p++;
+    } else if (*p) {
+      return false;
+    }
+
+    parsed[count++] = { (uint16_t)seconds, pattern, (uint8_t)repeat };
+  }
+
+  if (count == 0) {
+    return false;
+  }
+
+  memcpy(steps, parsed, count * sizeof(ProgramStep));
+  step_count = count;
+  position = 0;
+  repetition = 0;
+  active = false;
+  paused = false;
+  pending = false;
+  in_step = false;
+  return true;
+}
+
+// Starts from the beginning, or resumes a paused program at its current step
+bool TimerProgram::start() {
+  if (step_count == 0) {
+    return false;
+  }
+  if (!active) {
+    position = 0;
+    repetition = 0;
+    active = true;
+  }
+  paused = false;
+  pending = !in_step;
+  return true;
+}
+
+// Takes effect at the next step boundary; the running step finishes normally
+void TimerProgram::pause() {
+  if (active) {
+    paused = true;
+  }
+}
+
+// The running step was stopped by hand; hold the program at this step
+void TimerProgram::interrupt() {
+  if (in_step) {
+    in_step = false;
+    paused = true;
+  }
+}
+
+bool TimerProgram::takePendingStep(ProgramStep& step) {
+  if (!pending) {
+    return false;
+  }
+  pending = false;
+  in_step = true;
+  step = steps[position];
+  return true;
+}
+
+// Advances past the step that just finished; true if the next one should
+// start right away
+bool TimerProgram::stepCompleted() {
+  if (!in_step) {
+    return false;
+  }
+  in_step = false;
+
+  if (++repetition >= steps[position].repeat) {
+    repetition = 0;
+    position++;
+  }
+  if (position >= step_count) {
+    active = false;
+    position = 0;
+    return false;
+  }
+
+  pending = !paused;
+  return pending;
+}
+
+bool TimerProgram::isActive() {
+  return active;
+}
+
+bool TimerProgram::isPaused() {
+  return paused;
+}
+
+bool TimerProgram::ownsRun() {
+  return in_step;
+}
+
+const ProgramStep& TimerProgram::currentStep() {
+  return steps[position];
+}
+
+void TimerProgram::printStatus(Print& out) {
+  out.print("Program steps: ");
+  out.println(step_count);
+  out.print("Program state: ");
+  if (!active) {
+    out.println("stopped");
+  } else if (paused) {
+    out.println("paused");
+  } else {
+    out.println("running");
+  }
+  if (active) {
+    out.print("Step: ");
+    out.print(position + 1);
+    out.print("/");
+    out.println(step_count);
+    out.print("Repeat: ");
+    out.print(repetition + 1);
+    out.print("/");
+    out.println(steps[position].repeat);
+  }
+}
@@ -0,0 +1,50 @@
+#ifndef TIMER_PROGRAM_H
+#define TIMER_PROGRAM_H
+
+#include <Arduino.h>
+
+enum StepPattern : uint8_t {
+  PATTERN_SILENT,  // go straight to the next step
+  PATTERN_ALARM,   // snake animation and motor
+  PATTERN_DISPLAY  // snake animation only
+};
+
+// 4 bytes per step so a full program fits in a fixed 64-byte table
+struct ProgramStep {
+  uint16_t seconds;
+  uint8_t pattern;
+  uint8_t repeat;
+};
+
+class TimerProgram {
+  public:
+    TimerProgram();
+
+    bool load(const String& text);
+    bool start();
+    void pause();
+    void interrupt();
+
+    bool takePendingStep(ProgramStep& step);
+    bool stepCompleted();
+
+    bool isActive();
+    bool isPaused();
+    bool ownsRun();
+    const ProgramStep& currentStep();
+    void printStatus(Print& out);
+
+    static const uint8_t MAX_STEPS = 16;
+
+  private:
+    ProgramStep steps[MAX_STEPS];
+    uint8_t step_count;
+    uint8_t position;
+    uint8_t repetition;
+    bool active;
+    bool paused;
+    bool pending;
+    bool in_step;
+};
+
+#endif
@@ -0,0 +1,235 @@
+#include "WallClock.h"
+#include "Timebase.h"
+
+WallClock::WallClock()
+  : synced(false),
+    base_local(0),
+    base_wall(0),
+    drift_ppb(0),
+    history_count(0),
+    history_next(0),
+    last_offset(0),
+    last_delay(0),
+    best_delay(INT64_MAX),
+    sample_count(0),
+    alarm_armed(false),
+    alarm_fired(false),
+    alarm_second(0),
+    last_checked_second(0) {}
+
+// One NTP-style exchange: host sends at t1, device receives at t2 and
+// replies at t3, host receives at t4. Returns false if the sample was
+// rejected for an unusually long round trip.
+bool WallClock::addSample(int64_t t1, int64_t t2, int64_t t3, int64_t t4) {
+  int64_t delay = (t4 - t1) - (t3 - t2);
+  if (delay < 0 || t3 < t2) {
+    return false;
+  }
+
+  // USB latency is bursty; a round trip much slower than the best one
+  // seen has an asymmetric path and would only add noise
+  if (synced && delay > 2 * best_delay + 2000) {
+    return false;
+  }
+  if (delay < best_delay) {
+    best_delay = delay;
+  }
+
+  uint64_t local = (uint64_t)(t2 + t3) / 2;
+  int64_t wall = (t1 + t4) / 2;
+
+  if (synced) {
+    // A host clock step (e.g. an NTP correction) shows up as an impossible
+    // rate since the last sample; the time is taken over, but the samples
+    // before the step no longer fit a line with the new ones
+    int64_t elapsed_local = (int64_t)(local - base_local);
+    int64_t elapsed_wall = wall - base_wall;
+    if (elapsed_local >= 1000000) {
+      double ppb = (double)(elapsed_local - elapsed_wall) * 1e9 / elapsed_local;
+      if (ppb > MAX_DRIFT_PPB || ppb < -MAX_DRIFT_PPB) {
+        history_count = 0;
+      }
+    }
+    last_offset = wall - toWall(local);
+  }
+
+  history[history_next] = { local, wall };
+  history_next = (history_next + 1) % HISTORY;
+  if (history_count < HISTORY) {
+    history_count++;
+  }
+  fitDrift();
+
+  base_local = local;
+  base_wall = wall;
+  last_delay = delay;
+  synced = true;
+  sample_count++;
+  return true;
+}
+
+// Slope of (local - wall) against local time over the retained samples.
+// Each midpoint carries up to half the USB delay asymmetry as error, so the
+// rate is only as good as the baseline it is measured over; one fit over
+// many samples averages that out, where pairwise differences could not.
+// Runs once per exchange, so soft-float is cheap enough.
+void WallClock::fitDrift() {
+  if (history_count < 2) {
+    return;
+  }
+  int oldest = (history_next - history_count + HISTORY) % HISTORY;
+  int newest = (history_next - 1 + HISTORY) % HISTORY;
+  const Sample& origin = history[oldest];
+  // Over less than a second the delay noise swamps any rate
+  if ((int64_t)(history[newest].local - origin.local) < 1000000) {
+    return;
+  }
+
+  double sum_x = 0;
+  double sum_y = 0;
+  for (int i = 0; i < history_count; i++) {
+    const Sample& s = history[(oldest + i) % HISTORY];
+    double x = (double)(int64_t)(s.local - origin.local);
+    sum_x += x;
+    sum_y += x - (double)(s.wall - origin.wall);
+  }
+  double mean_x = sum_x / history_count;
+  double mean_y = sum_y / history_count;
+
+  double sxx = 0;
+  double sxy = 0;
+  for (int i = 0; i < history_count; i++) {
+    const Sample& s = history[(oldest + i) % HISTORY];
+    double x = (double)(int64_t)(s.local - origin.local);
+    double y = x - (double)(s.wall - origin.wall);
+    sxx += (x - mean_x) * (x - mean_x);
+    sxy += (x - mean_x) * (y - mean_y);
+  }
+
+  double ppb = sxy / sxx * 1e9;
+  if (ppb > MAX_DRIFT_PPB) {
+    ppb = MAX_DRIFT_PPB;
+  } else if (ppb < -MAX_DRIFT_PPB) {
+    ppb = -MAX_DRIFT_PPB;
+  }
+  drift_ppb = (int32_t)ppb;
+}
+
+bool WallClock::isSynced() {
+  return synced;
+}
+
+int64_t WallClock::now() {
+  return toWall(Timebase::now().us);
+}
+
+int64_t WallClock::toWall(uint64_t local_us) {
+  int64_t elapsed = (int64_t)(local_us - base_local);
+  // Split so a long free run cannot overflow the product
+  return base_wall + elapsed - elapsed / 1000 * drift_ppb / 1000000;
+}
+
+uint32_t WallClock::secondsOfDay() {
+  int64_t of_day = now() % US_PER_DAY;
+  if (of_day < 0) {
+    of_day += US_PER_DAY;
+  }
+  return (uint32_t)(of_day / 1000000);
+}
+
+int64_t WallClock::getOffsetUs() {
+  return last_offset;
+}
+
+int64_t WallClock::getLastDelayUs() {
+  return last_delay;
+}
+
+int32_t WallClock::getDriftPpb() {
+  return drift_ppb;
+}
+
+unsigned long WallClock::getSampleCount() {
+  return sample_count;
+}
+
+void WallClock::armAlarm(uint32_t second_of_day) {
+  alarm_second = second_of_day;
+  alarm_armed = true;
+  alarm_fired = false;
+  last_checked_second = synced ? secondsOfDay() : second_of_day;
+}
+
+void WallClock::disarmAlarm() {
+  alarm_armed = false;
+  alarm_fired = false;
+}
+
+bool WallClock::isAlarmArmed() {
+  return alarm_armed;
+}
+
+// Latches once the alarm time has passed and stays true until disarmed,
+// so an alarm that comes due mid-countdown is not lost
+bool WallClock::alarmDue() {
+  if (!alarm_armed || !synced) {
+    return false;
+  }
+  if (!alarm_fired) {
+    uint32_t second = secondsOfDay();
+    bool crossed;
+    if (second >= last_checked_second) {
+      crossed = alarm_second > last_checked_second && alarm_second <= second;
+    } else {
+      // Passed midnight since the last check
+      crossed = alarm_second > last_checked_second || alarm_second <= second;
+    }
+    last_checked_second = second;
+    alarm_fired = crossed;
+  }
+  return alarm_fired;
+}
+
+static void printTwoDigits(Print& out, uint32_t value) {
+  if (value < 10) {
+    out.print('0');
+  }
+  out.print(value);
+}
+
+void WallClock::printStatus(Print& out) {
+  out.print("Wall clock synced: ");
+  out.println(synced);
+  if (synced) {
+    uint32_t second = secondsOfDay();
+    out.print("Time: ");
+    printTwoDigits(out, second / 3600);
+    out.print(':');
+    printTwoDigits(out, (second / 60) % 60);
+    out.print(':');
+    printTwoDigits(out, second % 60);
+    out.println();
+  }
+  out.print("Samples: ");
+  out.println(sample_count);
+  out.print("Last offset: ");
+  out.print((long)last_offset);
+  out.println("us");
+  out.print("Last delay: ");
+  out.print((long)last_delay);
+  out.println("us");
+  out.print("Drift: ");
+  out.print(drift_ppb);
+  out.println("ppb");
+  out.print("Alarm: ");
+  if (alarm_armed) {
+    printTwoDigits(out, alarm_second / 3600);
+    out.print(':');
+    printTwoDigits(out, (alarm_second / 60) % 60);
+    out.print(':');
+    printTwoDigits(out, alarm_second % 60);
+    out.println(alarm_fired ? " (due)" : "");
+  } else {
+    out.println("off");
+  }
+}
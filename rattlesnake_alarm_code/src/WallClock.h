@@ -0,0 +1,64 @@
+#ifndef WALL_CLOCK_H
+#define WALL_CLOCK_H
+
+#include <Arduino.h>
+
+// Time of day disciplined against a host over the serial link. Host
+// timestamps are local wall-clock microseconds since 1970; device
+// timestamps come from the RP2040's 64-bit microsecond timer.
+class WallClock {
+  public:
+    WallClock();
+
+    bool addSample(int64_t t1, int64_t t2, int64_t t3, int64_t t4);
+    bool isSynced();
+    int64_t now();
+    int64_t toWall(uint64_t local_us);
+    uint32_t secondsOfDay();
+
+    int64_t getOffsetUs();
+    int64_t getLastDelayUs();
+    int32_t getDriftPpb();
+    unsigned long getSampleCount();
+
+    void armAlarm(uint32_t second_of_day);
+    void disarmAlarm();
+    bool isAlarmArmed();
+    bool alarmDue();
+
+    void printStatus(Print& out);
+
+    // Drift is the least-squares rate over this many recent samples
+    static const int HISTORY = 32;
+    // 1000 ppm; a larger rate between samples means the host clock stepped
+    static const int32_t MAX_DRIFT_PPB = 1000000;
+
+  private:
+    struct Sample {
+      uint64_t local;
+      int64_t wall;
+    };
+
+    bool synced;
+    uint64_t base_local;   // local time of the last accepted sample
+    int64_t base_wall;     // host time at base_local
+    int32_t drift_ppb;     // > 0 when the local crystal runs fast
+    Sample history[HISTORY];
+    int history_count;
+    int history_next;
+    int64_t last_offset;
+    int64_t last_delay;
+    int64_t best_delay;
+    unsigned long sample_count;
+
+    bool alarm_armed;
+    bool alarm_fired;
+    uint32_t alarm_second;
+    uint32_t last_checked_second;
+
+    static const int64_t US_PER_DAY = 86400LL * 1000000LL;
+
+    void fitDrift();
+};
+
+#endif
@@ -1,8 +1,25 @@
 #include <Arduino.h>
-#include <TM1637Display.h>
+#include "MirroredDisplay.h"
 #include "CountdownTimer.h"
 #include "Switch.h"
 #include "SerialCommands.h"
+#include "StateMachine.h"
+#include "PowerManager.h"
+#include "TimerProgram.h"
+#include "WallClock.h"
+#include "ResumeState.h"
+#include "Stopwatch.h"
+#include "DisplayEffects.h"
+#include "TaskSupervisor.h"
+#include "DmaUartStream.h"
+#include "MotorThermal.h"
+#include "SegmentFormat.h"
+#include "SyncLine.h"
+#include "BootProfile.h"
+#include "QuadratureEncoder.h"
+#include "hardware/gpio.h"
+#include "hardware/structs/sio.h"
+#include "Timebase.h"
 
 // Snake animation frames
 const uint8_t snakeFrames[] = {
@@ -26,147 +43,543 @@ int snakeIndex = 0;
 #define SWITCH 18
 #define CLK 13  
 #define DIO 12
+#define DISPLAY_BIT_DELAY 5 // us; the TM1637 clocks at up to 250 kHz, the library default is 100
+#define LINK_TX 8   // UART1, command link to a PLC or RS-485 transceiver
+#define LINK_RX 9
+#define LINK_DE -1  // RS-485 driver enable, -1 when not fitted
+#define SYNC_PIN 14 // open-drain start line shared between clocks
 
 // Global variables
-volatile int encoderPosition = 0;
-volatile bool encoderMoved = false;
-bool lastEncA = HIGH;
 bool motorStarted = false;
 
-bool alarmActive = false;
-unsigned long alarmStartTime = 0;
+Instant alarmStartTime = {0};
+bool alarmWithMotor = true;
+bool alarmDisplayOnly = false; // next alarm leaves the motor off
 const int alarmDuration = 5000; // 5 seconds
-unsigned long lastFlashTime = 0;
+Instant lastFlashTime = {0};
 
-unsigned long motorRunStartTime = 0;
-const unsigned long MAX_MOTOR_RUN_TIME = 15000; // 15 seconds max safety limit
+const uint16_t MOTOR_DUTY = 300; // permille
+uint16_t motorDuty = 0;
+
+const unsigned long EDIT_TIMEOUT = 3000; // back to idle after 3 seconds without edits
+
+const unsigned long ALARM_PULSE_PERIOD = 1000;
+const unsigned long FAULT_BLINK_PERIOD = 1000;
+
+// loop() must feed the watchdog within this; a full display frame is ~20ms
+const unsigned long WATCHDOG_TIMEOUT = 1000;
+
+const unsigned long LINK_BAUD = 115200;
 
 enum IncrementMode { INCREMENT_MIN, INCREMENT_SEC };
 IncrementMode currentMode = INCREMENT_MIN;
 
 // Objects
-TM1637Display display(CLK, DIO);
+MirroredDisplay display(CLK, DIO, DISPLAY_BIT_DELAY);
 CountdownTimer timer(display);
+Stopwatch stopwatch(display);
+DisplayEffects effects(display);
+TaskSupervisor supervisor;
+MotorThermal thermal;
+
+// Jobs run by loop(), each against its own budget
+TaskId taskTimer;
+TaskId taskInputs;
+TaskId taskSerial;
+TaskId taskAlarm;
+TaskId taskDisplay;
+TaskId taskPower;
+TaskId taskSave;
 Switch modeSwitch(SWITCH);
-SerialCommands serialCommands(timer);
+QuadratureEncoder encoder;
+StateMachine fsm;
+DmaUartStream uartLink(uart1, LINK_TX, LINK_RX, LINK_DE);
+SyncLine syncLine(SYNC_PIN);
+BootProfile boot;
+bool bannerShown = false;
+bool stopwatchReadingShown = false; // left up in idle until the next input
+SerialCommands serialCommands(Serial, timer, fsm);
+PowerManager power;
+TimerProgram program;
+WallClock wallClock;
+ResumeState resumeState;
 
 // Function declarations
 void toggleMode();
 void readEncoder();
-void stopAlarm();
 void handleAlarm();
+void motorOff();
+void setMotorDuty(uint16_t permille);
+void resumeAfterReset();
+void onSwitchEdge();
+void onEncoderEdge();
+void forceMotorSafe();
+void onLoopStall();
+void saveResumeState(unsigned long lead_ms);
+bool parseInt64s(const String& args, int64_t* values, int count);
+void printInt64(Print& out, int64_t value);
+
+// State actions
+void enterIdle();
+void exitIdle();
+void tickIdle();
+void tickEditing();
+void exitEditing();
+void enterRunning();
+void exitRunning();
+void tickRunning();
+void enterAlarming();
+void exitAlarming();
+void tickAlarming();
+void enterFault();
+void exitFault();
+void enterStopwatch();
+void exitStopwatch();
+void tickStopwatch();
 
+// Boot brings up what the operator sees and touches first: motor pins,
+// the first frame, then the inputs. Commands, USB and the link follow, and
+// the welcome banner waits in loop() until a host opens the port.
 void setup() {
-  Serial.begin(115200);
+  boot.mark("setup");
 
   pinMode(LED_PIN, OUTPUT);
   pinMode(MOT_IN1, OUTPUT);
   pinMode(MOT_IN2, OUTPUT);
   analogWriteResolution(10);
+  boot.mark("motor pins");
+
+  display.setBrightness(0x0f); 
+  timer.reset();
+  boot.mark("first frame");
 
   pinMode(ENC_A, INPUT_PULLUP);
   pinMode(ENC_B, INPUT_PULLUP);
 
-  display.setBrightness(0x0f); 
-  timer.reset();
+  // Any edge on the encoder or switch wakes the board from dormant idle.
+  // Every input has its own ISR that reports the wake: the switch so
+  // presses can be timestamped as laps, the encoder pins so no detent is
+  // missed while loop() waits on the display.
+  power.begin();
+  attachInterrupt(digitalPinToInterrupt(SWITCH), onSwitchEdge, CHANGE);
+  attachInterrupt(digitalPinToInterrupt(ENC_A), onEncoderEdge, CHANGE);
+  attachInterrupt(digitalPinToInterrupt(ENC_B), onEncoderEdge, CHANGE);
+  boot.mark("inputs");
+
+  Serial.begin(115200);
+
+  fsm.setActions(STATE_IDLE, enterIdle, exitIdle, tickIdle);
+  fsm.setActions(STATE_EDITING, nullptr, exitEditing, tickEditing);
+  fsm.setActions(STATE_RUNNING, enterRunning, exitRunning, tickRunning);
+  fsm.setActions(STATE_ALARMING, enterAlarming, exitAlarming, tickAlarming);
+  fsm.setActions(STATE_FAULT, enterFault, exitFault, nullptr);
+  fsm.setActions(STATE_STOPWATCH, enterStopwatch, exitStopwatch, tickStopwatch);
 
   // Set up timer callback
   timer.setOnFinished([]() {
-    alarmActive = true;
-    alarmStartTime = millis();
+    // Silent program steps chain straight into the next one without
+    // leaving the running state
+    if (program.ownsRun() && program.currentStep().pattern == PATTERN_SILENT) {
+      ProgramStep next;
+      if (program.stepCompleted() && program.takePendingStep(next)) {
+        timer.setTime(next.seconds);
+        timer.start();
+      } else {
+        fsm.dispatch(EVENT_STOP);
+      }
+      return;
+    }
     Serial.println("Timer finished - alarm activated!");
+    fsm.dispatch(EVENT_FINISHED);
   });
 
   // Set up switch handlers
   modeSwitch.setHandlers(
-    []() {  // short press
-      if (alarmActive) {
-        stopAlarm();
-      } else if (timer.isRunning()) {
-        timer.reset();
-      } else {
+    []() {  // short press: stop whatever is running, otherwise switch edit mode
+      if (fsm.getState() == STATE_STOPWATCH) {
+        return; // a lap, already recorded by onSwitchEdge()
+      }
+      if (!fsm.dispatch(EVENT_STOP)) {
         toggleMode();
+        fsm.dispatch(EVENT_EDIT);
       }
     },
-    []() {  // long press
-      if (alarmActive) {
-        stopAlarm();
-      } else if (timer.isRunning()) {
-        timer.reset();
-      } else {
-        timer.start();
+    []() {  // long press: start (a stopwatch from a 00:00 preset), or stop whatever is running
+      Event start = timer.getDefaultSeconds() == 0 ? EVENT_STOPWATCH : EVENT_START;
+      if (!fsm.dispatch(start)) {
+        fsm.dispatch(EVENT_STOP);
       }
     }
   );
 
   // Set up serial command callbacks
-  serialCommands.setStopAlarmCallback([]() {
-    stopAlarm();
-  });
-  
-  serialCommands.setAlarmStatusCallback([]() {
-    return alarmActive;
-  });
-  
   serialCommands.setMotorStatusCallback([]() {
     return motorStarted;
   });
 
-  serialCommands.printWelcomeMessage();
-}
+  serialCommands.addCommand("POWER", "POWER", [](const String& args, Print& out) {
+    power.printStatus(out);
+  });
 
-void loop() {
-  timer.update();
-  modeSwitch.update();
-  readEncoder();
-  serialCommands.update();
+  serialCommands.addCommand("POWER_TIMEOUT", "POWER_TIMEOUT <seconds>", [](const String& args, Print& out) {
+    long seconds = args.toInt();
+    power.setIdleTimeout(seconds > 0 ? seconds * 1000UL : 0);
+    out.print("Idle timeout set to ");
+    out.print(seconds > 0 ? seconds : 0);
+    out.println(" seconds");
+  });
 
-  if (alarmActive) {
-    if (motorRunStartTime == 0) {
-      motorRunStartTime = millis();
+  serialCommands.addCommand("PROGRAM_LOAD", "PROGRAM_LOAD <sec>:<A|D|S>[:<repeat>],...", [](const String& args, Print& out) {
+    if (program.isActive()) {
+      out.println("Cannot load program - a program is active");
+    } else if (program.load(args)) {
+      out.println("Program loaded");
+    } else {
+      out.println("Invalid program");
     }
-    
-    unsigned long motorRunTime = millis() - motorRunStartTime;
-    if (motorRunTime > MAX_MOTOR_RUN_TIME) {
-      Serial.print("SAFETY: Motor ran for ");
-      Serial.print(motorRunTime);
-      Serial.println("ms - forcing stop");
-      stopAlarm();
+  });
+
+  serialCommands.addCommand("PROGRAM_START", "PROGRAM_START", [](const String& args, Print& out) {
+    out.println(program.start() ? "Program started" : "No program loaded");
+  });
+
+  serialCommands.addCommand("PROGRAM_PAUSE", "PROGRAM_PAUSE", [](const String& args, Print& out) {
+    program.pause();
+    out.println("Program will pause after the current step");
+  });
+
+  serialCommands.addCommand("PROGRAM_STATUS", "PROGRAM_STATUS", [](const String& args, Print& out) {
+    program.printStatus(out);
+  });
+
+  // Host time sync: TIME_SYNC <t1> is answered with the device receive and
+  // transmit times, then the host reports all four timestamps back
+  serialCommands.addCommand("TIME_SYNC", "TIME_SYNC <t1>", [](const String& args, Print& out) {
+    int64_t t1;
+    if (!parseInt64s(args, &t1, 1)) {
+      out.println("Invalid TIME_SYNC");
+      return;
+    }
+    uint64_t t2 = serialCommands.getLineTime();
+    out.print("TIME_SYNC ");
+    out.print(args);
+    out.print(' ');
+    printInt64(out, t2);
+    out.print(' ');
+    printInt64(out, Timebase::now().us);
+    out.println();
+  });
+
+  serialCommands.addCommand("TIME_SYNC_DONE", "TIME_SYNC_DONE <t1> <t2> <t3> <t4>", [](const String& args, Print& out) {
+    int64_t t[4];
+    if (!parseInt64s(args, t, 4)) {
+      out.println("Invalid TIME_SYNC_DONE");
+    } else if (wallClock.addSample(t[0], t[1], t[2], t[3])) {
+      timer.setDriftCorrection(wallClock.getDriftPpb());
+      wallClock.printStatus(out);
     } else {
-      handleAlarm();
+      out.println("Sample rejected - round trip too slow");
     }
-  } else {
-    digitalWrite(MOT_IN1, LOW);
-    digitalWrite(MOT_IN2, LOW);
-    analogWrite(MOT_IN1, 0);
-  }
-  
-  delay(5);
-}
+  });
 
-void readEncoder() {
-  bool encA = digitalRead(ENC_A);
-  bool encB = digitalRead(ENC_B);
+  serialCommands.addCommand("TIME", "TIME", [](const String& args, Print& out) {
+    wallClock.printStatus(out);
+  });
 
-  if (encA != lastEncA && encA == LOW) {
-    if (encB == HIGH) {
-      encoderPosition++;
+  serialCommands.addCommand("ALARM_AT", "ALARM_AT <hh:mm:ss>|OFF", [](const String& args, Print& out) {
+    unsigned int h, m, sec;
+    if (args == "OFF") {
+      wallClock.disarmAlarm();
+      out.println("Wall-clock alarm off");
+    } else if (!wallClock.isSynced()) {
+      out.println("Cannot set alarm - clock not synced");
+    } else if (sscanf(args.c_str(), "%u:%u:%u", &h, &m, &sec) == 3 && h < 24 && m < 60 && sec < 60) {
+      wallClock.armAlarm(h * 3600 + m * 60 + sec);
+      out.print("Alarm set for ");
+      out.println(args);
     } else {
-      encoderPosition--;
+      out.println("Invalid time - use hh:mm:ss");
+    }
+  });
+
+  serialCommands.addCommand("MIRROR", "MIRROR ON|OFF", [](const String& args, Print& out) {
+    if (args == "ON") {
+      out.println("Display mirror on");
+      display.setMirror(&out);
+    } else if (args == "OFF") {
+      display.setMirror(nullptr);
+      out.println("Display mirror off");
+    } else {
+      out.println("Usage: MIRROR ON|OFF");
+    }
+  });
+
+  serialCommands.addCommand("DISPLAY_RATE", "DISPLAY_RATE <ms>", [](const String& args, Print& out) {
+    unsigned long interval = timer.setHighResInterval(args.toInt());
+    out.print("Final-minute refresh interval set to ");
+    out.print(interval);
+    out.println("ms");
+  });
+
+  serialCommands.addCommand("BENCH_RENDER", "BENCH_RENDER", [](const String& args, Print& out) {
+    SegmentFormat::printBenchmark(out);
+  });
+
+  serialCommands.addCommand("EFFECT", "EFFECT BLINK|PULSE <ms> | FADE <level> <ms> | OFF", [](const String& args, Print& out) {
+    String mode = args;
+    int space = mode.indexOf(' ');
+    String params = space >= 0 ? mode.substring(space + 1) : String("");
+    mode = space >= 0 ? mode.substring(0, space) : mode;
+    params.trim();
+
+    if (mode == "OFF") {
+      effects.stop();
+    } else if (mode == "BLINK" && params.toInt() > 0) {
+      effects.blink(params.toInt());
+    } else if (mode == "PULSE" && params.toInt() > 0) {
+      effects.pulse(params.toInt());
+    } else if (mode == "FADE" && params.indexOf(' ') > 0) {
+      long level = params.toInt();
+      long duration = params.substring(params.indexOf(' ') + 1).toInt();
+      if (level < 0 || level > 7 || duration < 0) {
+        out.println("Invalid fade - expected a level 0-7 and a duration in ms");
+        return;
+      }
+      effects.fade(level, duration);
+    } else {
+      out.println("Usage: EFFECT BLINK|PULSE <ms> | FADE <level> <ms> | OFF");
+      return;
+    }
+    out.print("Display effect: ");
+    out.println(DisplayEffects::modeName(effects.getMode()));
+  });
+
+  serialCommands.addCommand("STOPWATCH_START", "STOPWATCH_START", [](const String& args, Print& out) {
+    out.println(fsm.dispatch(EVENT_STOPWATCH) ? "Stopwatch started" : "Cannot start stopwatch - timer is busy");
+  });
+
+  serialCommands.addCommand("STOPWATCH_STOP", "STOPWATCH_STOP", [](const String& args, Print& out) {
+    if (fsm.getState() == STATE_STOPWATCH && fsm.dispatch(EVENT_STOP)) {
+      out.println("Stopwatch stopped");
+    } else {
+      out.println("Stopwatch is not running");
+    }
+  });
+
+  // Stamped with the time the line arrived, not when it was parsed
+  serialCommands.addCommand("LAP", "LAP", [](const String& args, Print& out) {
+    if (stopwatch.isRunning()) {
+      // The switch interrupt records laps too
+      noInterrupts();
+      stopwatch.lap(Instant{serialCommands.getLineTime()});
+      unsigned long count = stopwatch.getLapCount();
+      interrupts();
+      out.print("Lap ");
+      out.println(count);
+    } else {
+      out.println("Stopwatch is not running");
+    }
+  });
+
+  serialCommands.addCommand("LAPS", "LAPS", [](const String& args, Print& out) {
+    stopwatch.printLaps(out);
+  });
+
+  // Second command channel; responses go back to whichever link asked
+  uartLink.begin(LINK_BAUD);
+  serialCommands.addChannel(uartLink);
+
+  serialCommands.addCommand("LINK", "LINK", [](const String& args, Print& out) {
+    out.print("UART link: ");
+    out.print(LINK_BAUD);
+    out.print(" baud, receive overruns: ");
+    out.println(uartLink.getOverruns());
+  });
+
+  serialCommands.addCommand("THERMAL", "THERMAL", [](const String& args, Print& out) {
+    thermal.update(Timebase::now());
+    thermal.printStatus(out);
+  });
+
+  serialCommands.addCommand("THERMAL_CONFIG", "THERMAL_CONFIG <capacity_ms> <cooling_ms>", [](const String& args, Print& out) {
+    int space = args.indexOf(' ');
+    long capacity = args.toInt();
+    long cooling = space > 0 ? args.substring(space + 1).toInt() : 0;
+    if (capacity > 0 && cooling > 0 && thermal.configure(capacity, cooling)) {
+      out.println("Thermal model updated");
+    } else {
+      out.println("Invalid thermal model - capacity must be below the cooling time constant");
+    }
+  });
+
+  // Clocks armed on the shared line all start from the same falling edge;
+  // tickIdle() then moves the state machine along
+  syncLine.begin();
+
+  serialCommands.addCommand("SYNC_ARM", "SYNC_ARM", [](const String& args, Print& out) {
+    if (fsm.getState() != STATE_IDLE) {
+      out.print("Cannot arm sync - state is ");
+      out.println(StateMachine::stateName(fsm.getState()));
+    } else if (timer.getDefaultSeconds() <= 0) {
+      out.println("Cannot arm sync - time is zero");
+    } else {
+      syncLine.arm([](Instant edge) {
+        if (fsm.getState() != STATE_IDLE) {
+          return false;
+        }
+        timer.startAt(edge);
+        return timer.isRunning();
+      });
+      out.println("Sync armed");
+    }
+  });
+
+  serialCommands.addCommand("SYNC_DISARM", "SYNC_DISARM", [](const String& args, Print& out) {
+    syncLine.disarm();
+    out.println("Sync disarmed");
+  });
+
+  serialCommands.addCommand("SYNC_FIRE", "SYNC_FIRE", [](const String& args, Print& out) {
+    syncLine.fire();
+    out.println("Sync line pulsed");
+  });
+
+  serialCommands.addCommand("SYNC_STATUS", "SYNC_STATUS", [](const String& args, Print& out) {
+    syncLine.printStatus(out);
+  });
+
+  serialCommands.addCommand("TASKS", "TASKS", [](const String& args, Print& out) {
+    supervisor.printStatus(out);
+  });
+
+  // Critical jobs gate the watchdog feed; the motor safety limit lives in
+  // the alarm job, so a stall anywhere in it ends in a reset
+  taskTimer = supervisor.addTask("timer", 30000, true);
+  taskInputs = supervisor.addTask("inputs", 30000, true);
+  taskSerial = supervisor.addTask("serial", 50000, false);
+  taskAlarm = supervisor.addTask("alarm", 30000, true);
+  taskDisplay = supervisor.addTask("display", 5000, false);
+  taskPower = supervisor.addTask("power", 5000, false);
+  taskSave = supervisor.addTask("save", 1000, false);
+
+  // Dormant idle can last indefinitely and is not charged to any job. The
+  // UART link's DMA raises no interrupt, so it is switched to wake on receive.
+  power.setSleepHandlers(
+    []() {
+      supervisor.pause();
+      uartLink.armWake(PowerManager::onWakeEdge);
+    },
+    []() {
+      uartLink.disarmWake();
+      supervisor.resume();
     }
-    encoderMoved = true;
+  );
+
+  serialCommands.addCommand("RESET_REASON", "RESET_REASON", [](const String& args, Print& out) {
+    out.print("Reset reason: ");
+    out.println(ResumeState::resetReason());
+  });
+
+  serialCommands.addCommand("BOOT", "BOOT", [](const String& args, Print& out) {
+    boot.printTimeline(out);
+  });
+  boot.mark("commands");
+
+  resumeAfterReset();
+  supervisor.startWatchdog(WATCHDOG_TIMEOUT, onLoopStall);
+  boot.mark("ready");
+}
+
+// Picks the countdown or alarm back up if the last reset interrupted one
+void resumeAfterReset() {
+  ResumeSnapshot snapshot;
+  if (!resumeState.load(snapshot)) {
+    return;
+  }
+
+  timer.setTime(snapshot.default_seconds);
+  thermal.restore(snapshot.heat_percent, snapshot.motor_tripped, Timebase::now());
+  if (snapshot.alarm_pending) {
+    // loop() hung during this alarm and may do so again; restarting the
+    // motor would cycle it on every watchdog reset
+    alarmDisplayOnly = ResumeState::wasWatchdogTimeout();
+    Serial.println(alarmDisplayOnly ? "Resuming alarm after watchdog timeout - display only"
+                                    : "Resuming alarm after reset");
+    fsm.dispatch(EVENT_ALARM);
+  } else if (snapshot.running) {
+    // Time spent booting counts against the countdown. now() is exactly
+    // that time only when the reset restarted the TIMER; otherwise it also
+    // holds the uptime before the reset, and the boot time is not known.
+    unsigned long lost = ResumeState::timerWasReset() ? (unsigned long)Timebase::now().toMillis() : 0;
+    unsigned long remaining = snapshot.remaining_ms > lost ? snapshot.remaining_ms - lost : 1;
+    timer.resume(remaining);
+    fsm.dispatch(EVENT_START);
+    Serial.print("Resumed countdown after reset: ");
+    Serial.print(remaining);
+    Serial.println("ms remaining");
   }
-  lastEncA = encA;
+}
+
+void loop() {
+  supervisor.run(taskTimer, []() { timer.update(); });
+
+  supervisor.run(taskInputs, []() {
+    modeSwitch.update();
+    readEncoder();
+  });
+
+  supervisor.run(taskSerial, []() {
+    // Shown once a host has the port open, rather than making boot wait
+    if (!bannerShown && Serial) {
+      bannerShown = true;
+      serialCommands.printWelcomeMessage();
+      Serial.print("Reset reason: ");
+      Serial.println(ResumeState::resetReason());
+      boot.mark("usb banner");
+    }
+    if (serialCommands.update()) {
+      power.noteActivity();
+    }
+  });
+
+  supervisor.run(taskAlarm, []() {
+    // A wall-clock alarm that comes due mid-countdown waits for idle
+    if (wallClock.alarmDue() && fsm.dispatch(EVENT_ALARM)) {
+      Serial.println("Wall-clock alarm activated!");
+      wallClock.disarmAlarm();
+    }
+    fsm.tick();
+  });
+
+  supervisor.run(taskDisplay, []() { effects.update(); });
+
+  // Drops to a reduced clock after a period with no input while idle. Sleep
+  // only ends on an input, so an armed ALARM_AT keeps the clock awake to
+  // poll it; an armed sync does too, so edge latency matches across clocks.
+  // A running display effect would freeze mid-frame, so it keeps it awake too.
+  supervisor.run(taskPower, []() {
+    power.update(fsm.getState() == STATE_IDLE && !wallClock.isAlarmArmed() && !syncLine.isArmed() &&
+                 effects.getMode() == EFFECT_NONE);
+  });
 
-  if (encoderMoved && !timer.isRunning()) {
+  // Snapshot for a warm boot
+  supervisor.run(taskSave, []() { saveResumeState(0); });
+
+  supervisor.endPass();
+  delay(5);
+}
+
+// Applies every detent counted since the last pass as one edit; the timer
+// redraws on its own schedule, so a fast spin costs no extra bus traffic
+void readEncoder() {
+  int detents = encoder.takeDetents();
+
+  if (detents != 0) {
     int step = (currentMode == INCREMENT_MIN) ? 60 : 5;
 
-    if (encoderPosition > 0) {
-      timer.incrementTime(step);
-      encoderPosition = 0;
-    } else if (encoderPosition < 0) {
-      timer.incrementTime(-step);
-      encoderPosition = 0;
+    // Edits are only accepted while idle or editing
+    if (fsm.dispatch(EVENT_EDIT)) {
+      timer.incrementTime(detents * step);
     }
 
 /*         // Trigger appropriate blinking mode
@@ -177,28 +590,30 @@ void readEncoder() {
       timer.triggerBlink(BLINK_SECONDS);
       Serial.println("Blinking seconds");
     } */
-
-    encoderMoved = false;
   }
 }
 
 void handleAlarm() {
-  unsigned long now = millis();
-  unsigned long elapsedTime = now - alarmStartTime;
+  Instant now = Timebase::now();
+  unsigned long elapsedTime = (now - alarmStartTime).toMillis();
 
-  if (!motorStarted) {
-    float ASHER_MOTOR_PERCENT = 0.30;
-    analogWrite(MOT_IN1, (int)(1023 * ASHER_MOTOR_PERCENT)); 
-    digitalWrite(MOT_IN2, LOW);
+  if (!motorStarted && alarmWithMotor && !thermal.mayRun()) {
+    alarmWithMotor = false;
+    Serial.println("Motor is cooling down - alarm continues without it");
+  }
+
+  if (!motorStarted && alarmWithMotor) {
+    uint16_t allowed = thermal.maxDuty();
+    setMotorDuty(MOTOR_DUTY < allowed ? MOTOR_DUTY : allowed);
     motorStarted = true;
     Serial.print("Motor started at: ");
-    Serial.print(now);
+    Serial.print((unsigned long)now.toMillis());
     Serial.print("ms, alarm will stop at: ");
-    Serial.println(alarmStartTime + alarmDuration);
+    Serial.println((unsigned long)alarmStartTime.toMillis() + alarmDuration);
   }
 
   // Snake animation
-  if (now - lastFlashTime >= 250) {
+  if (now - lastFlashTime >= Duration::fromMillis(250)) {
     lastFlashTime = now;
     uint8_t frame = snakeFrames[snakeIndex];
     uint8_t segments[] = {frame, frame, frame, frame};
@@ -216,28 +631,226 @@ void handleAlarm() {
     Serial.print("Alarm duration elapsed: ");
     Serial.print(elapsedTime);
     Serial.println("ms - STOPPING ALARM");
-    stopAlarm();
+    fsm.dispatch(EVENT_ALARM_DONE);
   }
 }
 
-void stopAlarm() {
-  Serial.println("in StopAlarm");
-  alarmActive = false;
-  motorStarted = false; 
-  motorRunStartTime = 0;
-  
+void motorOff() {
+  motorStarted = false;
+  motorDuty = 0;
+  thermal.setDuty(0, Timebase::now());
+
   digitalWrite(MOT_IN1, LOW);
   digitalWrite(MOT_IN2, LOW);
   analogWrite(MOT_IN1, 0);
-  
+}
+
+void enterIdle() {
+  timer.reset(!stopwatchReadingShown);
+}
+
+// Whatever input ends idle, the preset replaces a held stopwatch reading
+void exitIdle() {
+  if (stopwatchReadingShown) {
+    stopwatchReadingShown = false;
+    timer.showTime(timer.getRemainingTime());
+  }
+}
+
+void tickIdle() {
+  // Started from the sync line interrupt
+  if (timer.isRunning()) {
+    fsm.dispatch(EVENT_START);
+    return;
+  }
+
+  // Next step of an uploaded program, if one is due
+  ProgramStep step;
+  if (program.takePendingStep(step)) {
+    timer.setTime(step.seconds);
+    fsm.dispatch(EVENT_START);
+  }
+}
+
+void tickEditing() {
+  if (Timebase::now() - fsm.getLastEventTime() >= Duration::fromMillis(EDIT_TIMEOUT)) {
+    fsm.dispatch(EVENT_EDIT_DONE);
+  }
+}
+
+// The edit has settled (timeout, start or stop), so it becomes the preset
+void exitEditing() {
+  timer.commitEdit();
+}
+
+void enterRunning() {
+  // Already running when resumed after a reset
+  if (!timer.isRunning()) {
+    timer.start();
+  }
+}
+
+// Left with time still on the clock, so the step was cut short and is run
+// again when the program resumes
+void exitRunning() {
+  if (timer.isRunning()) {
+    program.interrupt();
+  }
+}
+
+void tickRunning() {
+  // start() refuses a zero-length countdown; fall back to idle
+  if (!timer.isRunning()) {
+    fsm.dispatch(EVENT_STOP);
+  }
+}
+
+void enterAlarming() {
+  alarmWithMotor = !alarmDisplayOnly && !(program.ownsRun() && program.currentStep().pattern == PATTERN_DISPLAY);
+  alarmDisplayOnly = false;
+  alarmStartTime = Timebase::now();
+  effects.pulse(ALARM_PULSE_PERIOD);
+}
+
+// However the alarm ends (timeout, acknowledged, thermal fault) the
+// countdown behind it ran out, so its program step is done
+void exitAlarming() {
+  program.stepCompleted();
+  motorOff();
+  effects.stop();
   display.clear();
-  timer.reset();
-  
   Serial.println("Motor should be OFF now"); 
 }
 
+void tickAlarming() {
+  thermal.update(Timebase::now());
+  if (motorStarted && !thermal.mayRun()) {
+    Serial.println("SAFETY: Motor thermal limit reached - forcing stop");
+    fsm.dispatch(EVENT_FAULT);
+    return;
+  }
+
+  // Near the limit the model lowers the allowed duty
+  if (motorStarted && thermal.maxDuty() < motorDuty) {
+    setMotorDuty(thermal.maxDuty());
+  }
+  handleAlarm();
+}
+
+void setMotorDuty(uint16_t permille) {
+  analogWrite(MOT_IN1, (int)(1023UL * permille / 1000));
+  digitalWrite(MOT_IN2, LOW);
+  motorDuty = permille;
+  thermal.setDuty(permille, Timebase::now());
+}
+
+void enterFault() {
+  motorOff();
+  const uint8_t dashes[] = {SEG_G, SEG_G, SEG_G, SEG_G};
+  display.setSegments(dashes);
+  Serial.println("FAULT - press the switch or send TIMER_STOP to clear");
+  effects.blink(FAULT_BLINK_PERIOD);
+}
+
+void exitFault() {
+  effects.stop();
+}
+
+void enterStopwatch() {
+  stopwatch.start();
+}
+
+void exitStopwatch() {
+  stopwatch.stop();
+  stopwatchReadingShown = true;
+  Serial.print("Stopwatch stopped after ");
+  Serial.print((unsigned long)stopwatch.getElapsed().toMillis());
+  Serial.print("ms with ");
+  Serial.print(stopwatch.getLapCount());
+  Serial.println(" laps - send LAPS to read them");
+}
+
+void tickStopwatch() {
+  stopwatch.update();
+}
+
+// Presses are timestamped here rather than in loop(), so a lap is exact to
+// the microsecond even while a display frame is being clocked out
+void onSwitchEdge() {
+  PowerManager::onWakeEdge();
+  stopwatch.noteEdge(digitalRead(SWITCH) == LOW);
+}
+
+// Both encoder pins; the decoder's transition table absorbs contact bounce
+void onEncoderEdge() {
+  PowerManager::onWakeEdge();
+  encoder.onEdge(digitalRead(ENC_A) == HIGH, digitalRead(ENC_B) == HIGH);
+}
+
+// Snapshot for a warm boot; register writes only, so it is safe from the
+// stall interrupt too. lead_ms is time that passes before the reset, taken
+// off a running countdown up front.
+void saveResumeState(unsigned long lead_ms) {
+  State state = fsm.getState();
+  unsigned long remaining = timer.getRemainingMillis();
+  if (state == STATE_RUNNING) {
+    remaining = remaining > lead_ms ? remaining - lead_ms : 0;
+  }
+  resumeState.save(remaining, timer.getDefaultSeconds(),
+                   state == STATE_RUNNING, state == STATE_ALARMING,
+                   thermal.getHeatPercent(), !thermal.mayRun());
+}
+
+// The last loop() snapshot can be most of a watchdog period old; taking a
+// fresh one here bounds the resume error by the stall margin
+void onLoopStall() {
+  forceMotorSafe();
+  saveResumeState(TaskSupervisor::STALL_MARGIN_MS);
+}
+
+// Runs from the pre-watchdog interrupt when loop() has stalled. Plain SIO
+// writes, since the PWM driver or whatever holds up loop() may be stuck;
+// the watchdog reset that follows puts the pins back.
+void forceMotorSafe() {
+  const uint32_t mask = (1u << MOT_IN1) | (1u << MOT_IN2);
+  sio_hw->gpio_clr = mask;
+  sio_hw->gpio_oe_set = mask;
+  gpio_set_function(MOT_IN1, GPIO_FUNC_SIO);
+  gpio_set_function(MOT_IN2, GPIO_FUNC_SIO);
+}
+
 void toggleMode() {
   currentMode = (currentMode == INCREMENT_MIN) ? INCREMENT_SEC : INCREMENT_MIN;
   Serial.print("Mode: ");
   Serial.println(currentMode == INCREMENT_MIN ? "Minutes" : "Seconds");
+}
+
+bool parseInt64s(const String& args, int64_t* values, int count) {
+  const char* p = args.c_str();
+  for (int i = 0; i < count; i++) {
+    char* end;
+    values[i] = strtoll(p, &end, 10);
+    if (end == p) {
+      return false;
+    }
+    p = end;
+  }
+  return *p == '\0';
+}
+
+// Print has no 64-bit overloads on every core
+void printInt64(Print& out, int64_t value) {
+  char buf[21];
+  char* p = buf + sizeof(buf) - 1;
+  bool negative = value < 0;
+  uint64_t magnitude = negative ? -(uint64_t)value : (uint64_t)value;
+  *p = '\0';
+  do {
+    *--p = '0' + magnitude % 10;
+    magnitude /= 10;
+  } while (magnitude > 0);
+  if (negative) {
+    *--p = '-';
+  }
+  out.print(p);
 }
\ No newline at end of file
@@ -0,0 +1,195 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// Just enough of the Arduino core to build the hardware-independent modules
+// on a PC: String, Print and Stream behave like the real ones, pins and
+// interrupts do nothing. Used by the native test env and the fuzz targets.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdio.h>
+#include <algorithm>
+#include <string>
+#include "hardware/timer.h"
+
+using std::max;
+using std::min;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define CHANGE 2
+#define FALLING 3
+#define RISING 4
+#define DEC 10
+#define HEX 16
+
+typedef uint8_t byte;
+
+inline unsigned long millis() { return (unsigned long)(time_us_64() / 1000); }
+inline unsigned long micros() { return (unsigned long)time_us_64(); }
+inline void delay(unsigned long) {}
+inline void delayMicroseconds(unsigned int) {}
+inline void pinMode(int, int) {}
+inline int digitalRead(int) { return HIGH; }
+inline void digitalWrite(int, int) {}
+inline void analogWrite(int, int) {}
+inline void analogWriteResolution(int) {}
+inline int digitalPinToInterrupt(int pin) { return pin; }
+inline void attachInterrupt(int, void (*)(), int) {}
+inline void detachInterrupt(int) {}
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+class String {
+  public:
+    String(const char* text = "") : text(text ? text : "") {}
+    String(const std::string& text) : text(text) {}
+    String(char c) : text(1, c) {}
+    String(int value) : text(std::to_string(value)) {}
+    String(unsigned int value) : text(std::to_string(value)) {}
+    String(long value) : text(std::to_string(value)) {}
+    String(unsigned long value) : text(std::to_string(value)) {}
+
+    unsigned int length() const { return text.size(); }
+    const char* c_str() const { return text.c_str(); }
+    char charAt(unsigned int index) const { return index < text.size() ? text[index] : 0; }
+    char operator[](unsigned int index) const { return charAt(index); }
+
+    void trim() {
+      size_t first = 0;
+      while (first < text.size() && isspace((unsigned char)text[first])) {
+        first++;
+      }
+      size_t last = text.size();
+      while (last > first && isspace((unsigned char)text[last - 1])) {
+        last--;
+      }
+      text = text.substr(first, last - first);
+    }
+    void toUpperCase() {
+      for (size_t i = 0; i < text.size(); i++) {
+        text[i] = (char)toupper((unsigned char)text[i]);
+      }
+    }
+
+    String substring(unsigned int from) const {
+      return from < text.size() ? String(text.substr(from)) : String();
+    }
+    String substring(unsigned int from, unsigned int to) const {
+      if (from > to) {
+        std::swap(from, to);
+      }
+      if (from >= text.size()) {
+        return String();
+      }
+      return String(text.substr(from, std::min<size_t>(to, text.size()) - from));
+    }
+    int indexOf(char c, unsigned int from = 0) const {
+      size_t at = text.find(c, from);
+      return at == std::string::npos ? -1 : (int)at;
+    }
+    int indexOf(const String& s, unsigned int from = 0) const {
+      size_t at = text.find(s.text, from);
+      return at == std::string::npos ? -1 : (int)at;
+    }
+    bool startsWith(const String& prefix) const { return text.compare(0, prefix.text.size(), prefix.text) == 0; }
+    bool endsWith(const String& suffix) const {
+      return text.size() >= suffix.text.size() &&
+             text.compare(text.size() - suffix.text.size(), suffix.text.size(), suffix.text) == 0;
+    }
+    long toInt() const { return atol(text.c_str()); }
+    bool equals(const String& other) const { return text == other.text; }
+    bool equalsIgnoreCase(const String& other) const {
+      String a(*this), b(other);
+      a.toUpperCase();
+      b.toUpperCase();
+      return a.text == b.text;
+    }
+
+    String& operator+=(const String& other) { text += other.text; return *this; }
+    String& operator+=(const char* other) { text += other; return *this; }
+    String& operator+=(char c) { text += c; return *this; }
+    bool operator==(const String& other) const { return text == other.text; }
+    bool operator==(const char* other) const { return text == other; }
+    bool operator!=(const String& other) const { return text != other.text; }
+    bool operator!=(const char* other) const { return text != other; }
+
+  private:
+    std::string text;
+};
+
+inline String operator+(String a, const String& b) { a += b; return a; }
+
+class Print {
+  public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t b) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size) {
+      size_t n = 0;
+      while (size--) {
+        n += write(*buffer++);
+      }
+      return n;
+    }
+    size_t write(const char* text) { return text ? write((const uint8_t*)text, strlen(text)) : 0; }
+    virtual void flush() {}
+
+    size_t print(const char* text) { return write(text); }
+    size_t print(const String& s) { return write(s.c_str()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(unsigned char value, int base = DEC) { return printNumber(value, base); }
+    size_t print(int value, int base = DEC) { return printSigned(value, base); }
+    size_t print(unsigned int value, int base = DEC) { return printNumber(value, base); }
+    size_t print(long value, int base = DEC) { return printSigned(value, base); }
+    size_t print(unsigned long value, int base = DEC) { return printNumber(value, base); }
+    size_t print(long long value, int base = DEC) { return printSigned(value, base); }
+    size_t print(unsigned long long value, int base = DEC) { return printNumber(value, base); }
+    size_t print(double value, int digits = 2) {
+      char buffer[48];
+      snprintf(buffer, sizeof(buffer), "%.*f", digits, value);
+      return write(buffer);
+    }
+
+    size_t println() { return write("\r\n"); }
+    template <typename T>
+    size_t println(T value) { size_t n = print(value); return n + println(); }
+    template <typename T>
+    size_t println(T value, int format) { size_t n = print(value, format); return n + println(); }
+
+  private:
+    size_t printNumber(unsigned long long value, int base) {
+      char buffer[65];
+      char* p = &buffer[sizeof(buffer) - 1];
+      *p = '\0';
+      if (base < 2) {
+        base = DEC;
+      }
+      do {
+        int digit = value % base;
+        *--p = (char)(digit < 10 ? '0' + digit : 'A' + digit - 10);
+        value /= base;
+      } while (value);
+      return write(p);
+    }
+    size_t printSigned(long long value, int base) {
+      if (value < 0 && base == DEC) {
+        return print('-') + printNumber(0ULL - (unsigned long long)value, base);
+      }
+      return printNumber((unsigned long long)value, base);
+    }
+};
+
+class Stream : public Print {
+  public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+};
+
+#endif
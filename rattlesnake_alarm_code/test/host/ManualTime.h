@@ -0,0 +1,21 @@
+#ifndef HOST_MANUAL_TIME_H
+#define HOST_MANUAL_TIME_H
+
+#include "Timebase.h"
+
+// Time source that only moves when the test moves it. Installs itself as
+// the Timebase source for its lifetime.
+class ManualTime : public TimeSource {
+  public:
+    ManualTime(uint64_t start_us = 0) : now_us(start_us) { Timebase::setSource(this); }
+    ~ManualTime() { Timebase::setSource(nullptr); }
+
+    uint64_t nowMicros() override { return now_us; }
+    Instant now() { return Instant{now_us}; }
+    void advance(Duration d) { now_us += d.us; }
+    void advanceMillis(int64_t ms) { now_us += ms * 1000; }
+
+    uint64_t now_us;
+};
+
+#endif
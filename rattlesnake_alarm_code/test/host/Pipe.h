@@ -0,0 +1,55 @@
+#ifndef HOST_PIPE_H
+#define HOST_PIPE_H
+
+#include <Arduino.h>
+#include <deque>
+#include <string>
+
+// In-memory byte pipe with a Stream at each end, standing in for a serial
+// transport: what one end writes, the other end reads.
+class Pipe {
+  public:
+    class End : public Stream {
+      public:
+        End(std::deque<uint8_t>& in, std::deque<uint8_t>& out) : in(in), out(out) {}
+
+        int available() override { return (int)in.size(); }
+        int read() override {
+          if (in.empty()) {
+            return -1;
+          }
+          uint8_t b = in.front();
+          in.pop_front();
+          return b;
+        }
+        int peek() override { return in.empty() ? -1 : in.front(); }
+        size_t write(uint8_t b) override {
+          out.push_back(b);
+          return 1;
+        }
+        using Print::write;
+
+        // Everything the other end has written so far
+        std::string readAll() {
+          std::string text(in.begin(), in.end());
+          in.clear();
+          return text;
+        }
+
+      private:
+        std::deque<uint8_t>& in;
+        std::deque<uint8_t>& out;
+    };
+
+    Pipe() : host(to_host, to_device), device(to_device, to_host) {}
+
+  private:
+    std::deque<uint8_t> to_host;
+    std::deque<uint8_t> to_device;
+
+  public:
+    End host;
+    End device;
+};
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef HOST_TM1637_DISPLAY_H
+#define HOST_TM1637_DISPLAY_H
+
+#include <Arduino.h>
+
+#define SEG_A 0b00000001
+#define SEG_B 0b00000010
+#define SEG_C 0b00000100
+#define SEG_D 0b00001000
+#define SEG_E 0b00010000
+#define SEG_F 0b00100000
+#define SEG_G 0b01000000
+#define SEG_DP 0b10000000
+
+#define DEFAULT_BIT_DELAY 100
+
+// Same interface as avishorp/TM1637; keeps the last frame instead of
+// driving a bus, and counts the transfers a test may want to look at
+class TM1637Display {
+  public:
+    TM1637Display(uint8_t pinClk, uint8_t pinDIO, unsigned int bitDelay = DEFAULT_BIT_DELAY)
+      : frame{0, 0, 0, 0},
+        brightness(0),
+        frames_written(0),
+        m_bitDelay(bitDelay) {
+      (void)pinClk;
+      (void)pinDIO;
+    }
+
+    void setBrightness(uint8_t level, bool on = true) { brightness = (level & 0x7) | (on ? 0x08 : 0x00); }
+    void setSegments(const uint8_t segments[], uint8_t length = 4, uint8_t pos = 0) {
+      for (uint8_t i = 0; i < length && pos + i < 4; i++) {
+        frame[pos + i] = segments[i];
+      }
+      frames_written++;
+    }
+    void clear() {
+      const uint8_t blank[4] = {0, 0, 0, 0};
+      setSegments(blank);
+    }
+    void showNumberDec(int num, bool leading_zero = false, uint8_t length = 4, uint8_t pos = 0) {
+      showNumberDecEx(num, 0, leading_zero, length, pos);
+    }
+    void showNumberDecEx(int num, uint8_t dots = 0, bool leading_zero = false, uint8_t length = 4, uint8_t pos = 0) {
+      (void)num;
+      (void)dots;
+      (void)leading_zero;
+      uint8_t segments[4] = {0, 0, 0, 0};
+      setSegments(segments, length, pos);
+    }
+    static uint8_t encodeDigit(uint8_t digit) {
+      static const uint8_t digits[16] = {
+        0x3f, 0x06, 0x5b, 0x4f, 0x66, 0x6d, 0x7d, 0x07, 0x7f, 0x6f, 0x77, 0x7c, 0x39, 0x5e, 0x79, 0x71
+      };
+      return digits[digit & 0x0f];
+    }
+
+    uint8_t frame[4];
+    uint8_t brightness;
+    unsigned long frames_written;
+
+  protected:
+    void start() {}
+    void stop() {}
+    bool writeByte(uint8_t) { return true; }
+
+    unsigned int m_bitDelay;
+};
+
+#endif
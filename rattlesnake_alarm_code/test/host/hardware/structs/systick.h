@@ -0,0 +1,17 @@
+#ifndef HOST_HARDWARE_STRUCTS_SYSTICK_H
+#define HOST_HARDWARE_STRUCTS_SYSTICK_H
+
+#include <stdint.h>
+
+// A SysTick that never ticks; benchmarks report zero on the host
+typedef struct {
+  volatile uint32_t csr;
+  volatile uint32_t rvr;
+  volatile uint32_t cvr;
+  volatile uint32_t calib;
+} systick_hw_t;
+
+static systick_hw_t host_systick;
+#define systick_hw (&host_systick)
+
+#endif
@@ -0,0 +1,13 @@
+#ifndef HOST_HARDWARE_TIMER_H
+#define HOST_HARDWARE_TIMER_H
+
+#include <stdint.h>
+#include <chrono>
+
+// The RP2040 timer counts from reset; the host one from first use
+inline uint64_t time_us_64() {
+  static const std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - origin).count();
+}
+
+#endif
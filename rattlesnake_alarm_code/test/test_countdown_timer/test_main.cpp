@@ -0,0 +1,172 @@
+#include <unity.h>
+#include <string.h>
+#include "CountdownTimer.h"
+#include "SegmentFormat.h"
+#include "ManualTime.h"
+
+struct Bench {
+  ManualTime time;
+  MirroredDisplay display;
+  CountdownTimer timer;
+
+  Bench() : time(1000000), display(13, 12), timer(display) {
+    timer.reset();
+  }
+
+  bool shows(const uint8_t expected[4]) {
+    uint8_t frame[4];
+    display.getFrame(frame);
+    return memcmp(frame, expected, 4) == 0;
+  }
+};
+
+void setUp() {}
+void tearDown() {}
+
+static void test_edit_stops_at_display_limit() {
+  Bench bench;
+  bench.timer.setTime(SegmentFormat::MAX_SECONDS - 5);
+  bench.timer.incrementTime(60);
+  TEST_ASSERT_EQUAL(SegmentFormat::MAX_SECONDS, bench.timer.getDefaultSeconds());
+  bench.timer.incrementTime(60);
+  bench.timer.commitEdit();
+  TEST_ASSERT_EQUAL(SegmentFormat::MAX_SECONDS, bench.timer.getDefaultSeconds());
+
+  uint8_t expected[4];
+  SegmentFormat::clock(SegmentFormat::MAX_SECONDS, expected);
+  TEST_ASSERT_TRUE(bench.shows(expected));
+}
+
+static void test_edit_stops_at_zero() {
+  Bench bench;
+  bench.timer.setTime(5);
+  bench.timer.incrementTime(-60);
+  bench.timer.commitEdit();
+  TEST_ASSERT_EQUAL(0, bench.timer.getDefaultSeconds());
+}
+
+static void test_fast_spin_renders_once_per_interval() {
+  Bench bench;
+  bench.timer.setTime(10);
+  bench.time.advanceMillis(CountdownTimer::EDIT_RENDER_INTERVAL);
+  unsigned long before = bench.display.frames_written;
+
+  for (int i = 0; i < 40; i++) {
+    bench.timer.incrementTime(5);
+    bench.time.advanceMillis(1);
+    bench.timer.update();
+  }
+  // The value is current at once; the display caught up once
+  TEST_ASSERT_EQUAL(210, bench.timer.getDefaultSeconds());
+  TEST_ASSERT_EQUAL(1, bench.display.frames_written - before);
+
+  bench.time.advanceMillis(CountdownTimer::EDIT_RENDER_INTERVAL);
+  bench.timer.update();
+  uint8_t expected[4];
+  SegmentFormat::clock(210, expected);
+  TEST_ASSERT_TRUE(bench.shows(expected));
+  TEST_ASSERT_TRUE(bench.timer.hasPendingEdit());
+}
+
+static void test_hundredths_below_threshold() {
+  Bench bench;
+  bench.timer.setTime(61);
+  bench.timer.start();
+  bench.time.advanceMillis(500);
+  bench.timer.update();
+  uint8_t expected[4];
+  SegmentFormat::clock(61, expected);
+  TEST_ASSERT_TRUE(bench.shows(expected));
+
+  bench.time.advanceMillis(2500);
+  bench.timer.update();
+  SegmentFormat::hundredths(CountdownTimer::HIGH_RES_THRESHOLD - 2000, expected);
+  TEST_ASSERT_TRUE(bench.shows(expected));
+}
+
+// The off phase blanks the edited digits but keeps the colon, and shows
+// the pending edit rather than the old preset
+static void test_edit_blink_keeps_colon() {
+  Bench bench;
+  bench.timer.setTime(90);
+  bench.timer.incrementTime(60);
+  bench.timer.triggerBlink(BLINK_MINUTES);
+  bench.time.advanceMillis(400);
+  bench.timer.update();
+
+  uint8_t frame[4];
+  bench.display.getFrame(frame);
+  uint8_t expected[4];
+  SegmentFormat::clock(150, expected);
+  TEST_ASSERT_EQUAL_HEX8(0x00, frame[0]);
+  TEST_ASSERT_EQUAL_HEX8(0x80, frame[1]);
+  TEST_ASSERT_EQUAL_HEX8(expected[2], frame[2]);
+  TEST_ASSERT_EQUAL_HEX8(expected[3], frame[3]);
+
+  bench.time.advanceMillis(100);
+  bench.timer.update();
+  TEST_ASSERT_TRUE(bench.shows(expected));
+}
+
+// 01:40 could be 100 seconds or 100 minutes; hh:mm must look different
+static void test_hours_minutes_differs_from_minutes_seconds() {
+  uint8_t segments[4];
+  const uint8_t mm_ss[4] = {0x3f, 0x86, 0x66, 0x3f};  // 01:40
+  SegmentFormat::clock(100, segments);
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(mm_ss, segments, 4);
+  SegmentFormat::clock(101, segments);
+  TEST_ASSERT_EQUAL_HEX8(0x86, segments[1]);
+
+  const uint8_t hh_mm_even[4] = {0x00, 0x06, 0x66, 0x3f}; //  1 40
+  const uint8_t hh_mm_odd[4] = {0x00, 0x86, 0x66, 0x3f};  //  1:40
+  SegmentFormat::clock(6000, segments);
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(hh_mm_even, segments, 4);
+  SegmentFormat::clock(6001, segments);
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(hh_mm_odd, segments, 4);
+
+  // Two-digit hours keep both digits, so only the colon tells 10:00 apart
+  const uint8_t ten_hours[4] = {0x06, 0x3f, 0x3f, 0x3f};
+  SegmentFormat::clock(36000, segments);
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(ten_hours, segments, 4);
+}
+
+static void test_high_res_interval_is_bounded() {
+  Bench bench;
+  TEST_ASSERT_EQUAL(CountdownTimer::MIN_HIGH_RES_INTERVAL, bench.timer.setHighResInterval(0));
+  TEST_ASSERT_EQUAL(CountdownTimer::MAX_HIGH_RES_INTERVAL, bench.timer.setHighResInterval(5000));
+  // DISPLAY_RATE -1 arrives as a huge unsigned value
+  TEST_ASSERT_EQUAL(CountdownTimer::MAX_HIGH_RES_INTERVAL, bench.timer.setHighResInterval((unsigned long)-1));
+  TEST_ASSERT_EQUAL(100, bench.timer.setHighResInterval(100));
+}
+
+// A stopwatch reading left on the display survives the return to idle, and
+// the next showTime draws the whole preset over it
+static void test_quiet_reset_keeps_foreign_frame() {
+  Bench bench;
+  bench.timer.setTime(90);
+  const uint8_t reading[4] = {0x3f, 0x06, 0x5b, 0x4f};
+  bench.display.setSegments(reading);
+
+  unsigned long before = bench.display.frames_written;
+  bench.timer.reset(false);
+  TEST_ASSERT_EQUAL(before, bench.display.frames_written);
+  TEST_ASSERT_TRUE(bench.shows(reading));
+
+  bench.timer.showTime(bench.timer.getRemainingTime());
+  uint8_t expected[4];
+  SegmentFormat::clock(90, expected);
+  TEST_ASSERT_TRUE(bench.shows(expected));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_edit_stops_at_display_limit);
+  RUN_TEST(test_edit_stops_at_zero);
+  RUN_TEST(test_fast_spin_renders_once_per_interval);
+  RUN_TEST(test_hundredths_below_threshold);
+  RUN_TEST(test_edit_blink_keeps_colon);
+  RUN_TEST(test_hours_minutes_differs_from_minutes_seconds);
+  RUN_TEST(test_high_res_interval_is_bounded);
+  RUN_TEST(test_quiet_reset_keeps_foreign_frame);
+  return UNITY_END();
+}
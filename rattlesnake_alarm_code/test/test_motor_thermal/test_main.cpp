@@ -0,0 +1,168 @@
+#include <unity.h>
+#include "MotorThermal.h"
+
+// The default model: 5 s at full duty from cold, 60 s cooling constant.
+// Time is stepped like the alarm job does, re-checking every STEP_MS.
+static const unsigned long STEP_MS = 100;
+static const uint16_t ALARM_DUTY = 300; // MOTOR_DUTY in main.cpp
+static const unsigned long ALARM_MS = 5000;
+
+struct Bench {
+  MotorThermal thermal;
+  Instant now;
+
+  Bench() : now{0} {}
+
+  // Runs the motor at `duty` (capped by the model, as tickAlarming() does)
+  // for up to `ms`; returns how long it ran before the limiter tripped
+  unsigned long run(uint16_t duty, unsigned long ms) {
+    thermal.setDuty(duty, now);
+    for (unsigned long t = 0; t < ms; t += STEP_MS) {
+      now = now + Duration::fromMillis(STEP_MS);
+      thermal.update(now);
+      if (!thermal.mayRun()) {
+        thermal.setDuty(0, now);
+        return t + STEP_MS;
+      }
+      if (thermal.maxDuty() < duty) {
+        thermal.setDuty(thermal.maxDuty(), now);
+      }
+    }
+    thermal.setDuty(0, now);
+    return ms;
+  }
+
+  void rest(unsigned long ms) {
+    thermal.setDuty(0, now);
+    now = now + Duration::fromMillis(ms);
+    thermal.update(now);
+  }
+};
+
+void setUp() {}
+void tearDown() {}
+
+// Heat rises toward duty x time constant, so at 30% the 5 s capacity is
+// reached after -60 s x ln(1 - 5/18), about 19.5 s
+static void test_single_run_trips_near_19_5_s() {
+  Bench bench;
+  unsigned long ran = bench.run(ALARM_DUTY, 60000);
+  TEST_ASSERT_UINT32_WITHIN(1000, 19500, ran);
+  TEST_ASSERT_FALSE(bench.thermal.mayRun());
+  TEST_ASSERT_EQUAL(0, bench.thermal.maxDuty());
+}
+
+static void test_short_alarm_from_cold_runs_at_full_request() {
+  Bench bench;
+  TEST_ASSERT_EQUAL(ALARM_MS, bench.run(ALARM_DUTY, ALARM_MS));
+  TEST_ASSERT_TRUE(bench.thermal.mayRun());
+  TEST_ASSERT_EQUAL(1000, bench.thermal.maxDuty());
+}
+
+static void test_derating_is_linear_above_80_percent() {
+  Bench bench;
+  bench.thermal.setDuty(1000, bench.now);
+  uint16_t last = 1000;
+  while (bench.thermal.getHeatPercent() < MotorThermal::DERATE_START) {
+    TEST_ASSERT_EQUAL(1000, bench.thermal.maxDuty());
+    bench.now = bench.now + Duration::fromMillis(STEP_MS);
+    bench.thermal.update(bench.now);
+  }
+  while (bench.thermal.mayRun()) {
+    uint8_t percent = bench.thermal.getHeatPercent();
+    uint16_t allowed = bench.thermal.maxDuty();
+    // 1000 permille at 80% down to MIN_DUTY at 100%
+    uint16_t expected = 1000 - (1000 - MotorThermal::MIN_DUTY) * (percent - 80) / 20;
+    TEST_ASSERT_UINT32_WITHIN(40, expected, allowed);
+    TEST_ASSERT_TRUE(allowed <= last);
+    TEST_ASSERT_TRUE(allowed >= MotorThermal::MIN_DUTY);
+    last = allowed;
+    bench.now = bench.now + Duration::fromMillis(STEP_MS);
+    bench.thermal.update(bench.now);
+  }
+}
+
+// From capacity down to RESUME_LEVEL takes 60 s x ln 2, about 41.6 s
+static void test_cooldown_resumes_below_half_capacity() {
+  Bench bench;
+  bench.run(1000, 60000);
+  TEST_ASSERT_FALSE(bench.thermal.mayRun());
+
+  bench.rest(40000);
+  TEST_ASSERT_FALSE(bench.thermal.mayRun());
+  TEST_ASSERT_TRUE(bench.thermal.getHeatPercent() >= MotorThermal::RESUME_LEVEL);
+
+  bench.rest(3000);
+  TEST_ASSERT_TRUE(bench.thermal.mayRun());
+  TEST_ASSERT_TRUE(bench.thermal.getHeatPercent() < MotorThermal::RESUME_LEVEL);
+  TEST_ASSERT_EQUAL(1000, bench.thermal.maxDuty());
+}
+
+// Heat carries over between alarms: with a second between them the fifth
+// 5 s alarm trips, where a lone alarm never comes close
+static void test_back_to_back_alarms_accumulate() {
+  Bench bench;
+  int alarms = 0;
+  while (alarms < 10) {
+    alarms++;
+    if (bench.run(ALARM_DUTY, ALARM_MS) < ALARM_MS) {
+      break;
+    }
+    bench.rest(1000);
+  }
+  TEST_ASSERT_FALSE(bench.thermal.mayRun());
+  TEST_ASSERT_EQUAL(5, alarms);
+
+  // After a long pause the same sequence starts over from nearly cold
+  bench.rest(600000);
+  TEST_ASSERT_TRUE(bench.thermal.mayRun());
+  TEST_ASSERT_EQUAL(0, bench.thermal.getHeatPercent());
+  TEST_ASSERT_EQUAL(ALARM_MS, bench.run(ALARM_DUTY, ALARM_MS));
+}
+
+// Dormant idle can leave days between updates; the catch-up must end cold
+// and ready, not spin through a week of Euler steps
+static void test_multi_day_gap_cools_fully() {
+  Bench bench;
+  bench.run(1000, 60000);
+  TEST_ASSERT_FALSE(bench.thermal.mayRun());
+
+  bench.rest(7UL * 24 * 3600 * 1000);
+  TEST_ASSERT_TRUE(bench.thermal.mayRun());
+  TEST_ASSERT_EQUAL(0, bench.thermal.getHeatPercent());
+  TEST_ASSERT_EQUAL(1000, bench.thermal.maxDuty());
+  // Same room as from cold
+  TEST_ASSERT_UINT32_WITHIN(1000, 19500, bench.run(ALARM_DUTY, 60000));
+}
+
+static void test_restore_carries_heat_over_a_reset() {
+  Bench bench;
+  bench.thermal.restore(100, true, bench.now);
+  TEST_ASSERT_FALSE(bench.thermal.mayRun());
+
+  bench.thermal.restore(90, false, bench.now);
+  TEST_ASSERT_TRUE(bench.thermal.mayRun());
+  TEST_ASSERT_TRUE(bench.thermal.maxDuty() < 1000);
+  // Less room than from cold
+  TEST_ASSERT_TRUE(bench.run(ALARM_DUTY, 60000) < 5000);
+}
+
+static void test_configure_rejects_unreachable_capacity() {
+  MotorThermal thermal;
+  TEST_ASSERT_FALSE(thermal.configure(0, 60000));
+  TEST_ASSERT_FALSE(thermal.configure(60000, 60000));
+  TEST_ASSERT_TRUE(thermal.configure(10000, 120000));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_single_run_trips_near_19_5_s);
+  RUN_TEST(test_short_alarm_from_cold_runs_at_full_request);
+  RUN_TEST(test_derating_is_linear_above_80_percent);
+  RUN_TEST(test_cooldown_resumes_below_half_capacity);
+  RUN_TEST(test_back_to_back_alarms_accumulate);
+  RUN_TEST(test_multi_day_gap_cools_fully);
+  RUN_TEST(test_restore_carries_heat_over_a_reset);
+  RUN_TEST(test_configure_rejects_unreachable_capacity);
+  return UNITY_END();
+}
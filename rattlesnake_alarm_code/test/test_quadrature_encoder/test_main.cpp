@@ -0,0 +1,87 @@
+#include <unity.h>
+#include "QuadratureEncoder.h"
+
+// Pin levels as (A, B) pairs; A leading B is one detent forward
+static const bool FORWARD[4][2] = {{false, true}, {false, false}, {true, false}, {true, true}};
+static const bool BACKWARD[4][2] = {{true, false}, {false, false}, {false, true}, {true, true}};
+
+static void turn(QuadratureEncoder& encoder, const bool sequence[4][2], int bounces = 0) {
+  bool a = true;
+  bool b = true;
+  for (int i = 0; i < 4; i++) {
+    // A bouncing contact toggles the pin that is changing a few times
+    // before it settles on its new level
+    for (int n = 0; n < bounces; n++) {
+      encoder.onEdge(sequence[i][0], sequence[i][1]);
+      encoder.onEdge(a, b);
+    }
+    a = sequence[i][0];
+    b = sequence[i][1];
+    encoder.onEdge(a, b);
+  }
+}
+
+void setUp() {}
+void tearDown() {}
+
+static void test_clean_detents_count_both_ways() {
+  QuadratureEncoder encoder;
+  turn(encoder, FORWARD);
+  turn(encoder, FORWARD);
+  turn(encoder, FORWARD);
+  TEST_ASSERT_EQUAL(3, encoder.takeDetents());
+  turn(encoder, BACKWARD);
+  TEST_ASSERT_EQUAL(-1, encoder.takeDetents());
+  TEST_ASSERT_EQUAL(0, encoder.takeDetents());
+}
+
+static void test_contact_bounce_is_ignored() {
+  QuadratureEncoder encoder;
+  turn(encoder, FORWARD, 5);
+  turn(encoder, FORWARD, 3);
+  turn(encoder, BACKWARD, 4);
+  turn(encoder, FORWARD, 5);
+  TEST_ASSERT_EQUAL(2, encoder.takeDetents());
+}
+
+static void test_bounce_at_rest_counts_nothing() {
+  QuadratureEncoder encoder;
+  for (int i = 0; i < 20; i++) {
+    encoder.onEdge(false, true);
+    encoder.onEdge(true, true);
+    encoder.onEdge(true, false);
+    encoder.onEdge(true, true);
+  }
+  TEST_ASSERT_EQUAL(0, encoder.takeDetents());
+}
+
+static void test_half_turn_and_back_counts_nothing() {
+  QuadratureEncoder encoder;
+  encoder.onEdge(false, true);
+  encoder.onEdge(false, false);
+  encoder.onEdge(false, true);
+  encoder.onEdge(true, true);
+  TEST_ASSERT_EQUAL(0, encoder.takeDetents());
+}
+
+static void test_missed_edge_does_not_count_or_stick() {
+  QuadratureEncoder encoder;
+  // 11 -> 00 skips a state; the detent is dropped rather than guessed
+  encoder.onEdge(false, false);
+  encoder.onEdge(true, false);
+  encoder.onEdge(true, true);
+  TEST_ASSERT_EQUAL(0, encoder.takeDetents());
+  // The next clean detent counts normally
+  turn(encoder, FORWARD);
+  TEST_ASSERT_EQUAL(1, encoder.takeDetents());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_clean_detents_count_both_ways);
+  RUN_TEST(test_contact_bounce_is_ignored);
+  RUN_TEST(test_bounce_at_rest_counts_nothing);
+  RUN_TEST(test_half_turn_and_back_counts_nothing);
+  RUN_TEST(test_missed_edge_does_not_count_or_stick);
+  return UNITY_END();
+}
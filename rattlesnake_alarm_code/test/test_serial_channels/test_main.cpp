@@ -0,0 +1,128 @@
+#include <unity.h>
+#include "SerialCommands.h"
+#include "ManualTime.h"
+#include "Pipe.h"
+
+// The command core with a USB channel and a second link, each an in-memory
+// pipe; the test plays the host at the far end of both
+struct Bench {
+  ManualTime time;
+  Pipe usb;
+  Pipe link;
+  MirroredDisplay display;
+  CountdownTimer timer;
+  StateMachine fsm;
+  SerialCommands commands;
+
+  Bench()
+    : time(1000000),
+      display(13, 12),
+      timer(display),
+      commands(usb.device, timer, fsm) {
+    commands.addChannel(link.device);
+    timer.reset();
+  }
+
+  void pass(int count = 1) {
+    for (int i = 0; i < count; i++) {
+      time.advanceMillis(5);
+      commands.update();
+    }
+  }
+};
+
+void setUp() {}
+void tearDown() {}
+
+static void test_reply_goes_to_the_sending_channel() {
+  Bench bench;
+  bench.link.host.print("SET_TIME 90\n");
+  bench.pass();
+
+  TEST_ASSERT_EQUAL_STRING("Received command: SET_TIME 90\r\nTimer set to 90 seconds\r\n",
+                           bench.link.host.readAll().c_str());
+  TEST_ASSERT_EQUAL_STRING("", bench.usb.host.readAll().c_str());
+  TEST_ASSERT_EQUAL(90, bench.timer.getDefaultSeconds());
+}
+
+static void test_partial_lines_do_not_mix() {
+  Bench bench;
+  bench.usb.host.print("SET_TI");
+  bench.link.host.print("STA");
+  bench.pass();
+  bench.link.host.print("TUS\n");
+  bench.usb.host.print("ME 30\n");
+  bench.pass();
+
+  std::string usb = bench.usb.host.readAll();
+  std::string link = bench.link.host.readAll();
+  TEST_ASSERT_EQUAL_STRING("Received command: SET_TIME 30\r\nTimer set to 30 seconds\r\n", usb.c_str());
+  TEST_ASSERT_EQUAL(0u, link.find("Received command: STATUS\r\n"));
+  TEST_ASSERT_EQUAL(std::string::npos, link.find("SET_TIME"));
+}
+
+static void test_one_line_per_channel_per_pass() {
+  Bench bench;
+  bench.usb.host.print("STATUS\nSTATUS\n");
+  bench.link.host.print("STATUS\n");
+  bench.pass();
+
+  // Both channels are served in the same pass; the second USB line waits
+  std::string usb = bench.usb.host.readAll();
+  TEST_ASSERT_EQUAL(0u, usb.find("Received command: STATUS"));
+  TEST_ASSERT_EQUAL(std::string::npos, usb.find("Received command: STATUS", 1));
+  TEST_ASSERT_EQUAL(0u, bench.link.host.readAll().find("Received command: STATUS"));
+
+  bench.pass();
+  TEST_ASSERT_EQUAL(0u, bench.usb.host.readAll().find("Received command: STATUS"));
+}
+
+static void test_handlers_write_to_the_sender() {
+  Bench bench;
+  bench.commands.addCommand("PING", "PING", [](const String& args, Print& out) {
+    out.println("PONG");
+  });
+  bench.link.host.print("ping\r\n");
+  bench.pass();
+
+  TEST_ASSERT_EQUAL_STRING("Received command: PING\r\nPONG\r\n", bench.link.host.readAll().c_str());
+  TEST_ASSERT_EQUAL_STRING("", bench.usb.host.readAll().c_str());
+}
+
+static void test_overlong_line_is_confined_to_its_channel() {
+  Bench bench;
+  bench.link.host.print(std::string(200, 'X').c_str());
+  bench.usb.host.print("SET_TIME 45\n");
+  bench.pass();
+  bench.link.host.print("\nSET_TIME 20\n");
+  bench.pass(2);
+
+  TEST_ASSERT_EQUAL_STRING("Received command: SET_TIME 45\r\nTimer set to 45 seconds\r\n",
+                           bench.usb.host.readAll().c_str());
+  std::string link = bench.link.host.readAll();
+  TEST_ASSERT_EQUAL(0u, link.find("Command too long\r\n"));
+  TEST_ASSERT_NOT_EQUAL(std::string::npos, link.find("Timer set to 20 seconds"));
+}
+
+static void test_line_time_is_the_terminator_arrival() {
+  Bench bench;
+  bench.link.host.print("STATUS");
+  bench.pass();
+  uint64_t before = bench.time.now().us;
+  bench.link.host.print("\n");
+  bench.pass();
+
+  // Stamped when the newline was read, not when the line started
+  TEST_ASSERT_TRUE(bench.commands.getLineTime() > before);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_reply_goes_to_the_sending_channel);
+  RUN_TEST(test_partial_lines_do_not_mix);
+  RUN_TEST(test_one_line_per_channel_per_pass);
+  RUN_TEST(test_handlers_write_to_the_sender);
+  RUN_TEST(test_overlong_line_is_confined_to_its_channel);
+  RUN_TEST(test_line_time_is_the_terminator_arrival);
+  return UNITY_END();
+}
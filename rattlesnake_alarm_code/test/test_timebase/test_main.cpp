@@ -0,0 +1,89 @@
+#include <unity.h>
+#include "Timebase.h"
+#include "CountdownTimer.h"
+#include "ManualTime.h"
+
+// Where the old 32-bit counters wrapped: micros() after ~71.6 minutes,
+// millis() after ~49.7 days
+static const uint64_t MICROS_WRAP = 1ULL << 32;
+static const uint64_t MILLIS_WRAP_US = (1ULL << 32) * 1000;
+
+void setUp() {}
+void tearDown() {}
+
+static void test_source_is_injectable() {
+  {
+    ManualTime time(123456789);
+    TEST_ASSERT_EQUAL(123456789, Timebase::now().us);
+    time.advance(Duration::fromMicros(7));
+    TEST_ASSERT_EQUAL(123456796, Timebase::now().us);
+  }
+  // Back on the hardware timer once the source is gone
+  Instant a = Timebase::now();
+  Instant b = Timebase::now();
+  TEST_ASSERT_TRUE(b >= a);
+  TEST_ASSERT_TRUE(a.us != 123456796);
+}
+
+static void test_deadline_across_old_wraps() {
+  const uint64_t wraps[] = {MICROS_WRAP, MILLIS_WRAP_US};
+  for (uint64_t wrap : wraps) {
+    ManualTime time(wrap - 1500);
+    Deadline deadline = Deadline::after(time.now(), Duration::fromMillis(3));
+    TEST_ASSERT_FALSE(deadline.expired(time.now()));
+
+    time.advance(Duration::fromMicros(2000)); // past the wrap
+    TEST_ASSERT_FALSE(deadline.expired(time.now()));
+    TEST_ASSERT_EQUAL(1000, deadline.remaining(time.now()).us);
+
+    time.advance(Duration::fromMicros(1000));
+    TEST_ASSERT_TRUE(deadline.expired(time.now()));
+    TEST_ASSERT_EQUAL(0, deadline.remaining(time.now()).us);
+  }
+}
+
+static void test_durations_keep_microseconds() {
+  Instant start{1000};
+  Instant end = start + Duration::fromMicros(1999);
+  TEST_ASSERT_EQUAL(1999, (end - start).us);
+  TEST_ASSERT_EQUAL(1, (end - start).toMillis());
+  TEST_ASSERT_EQUAL(-1999, (start - end).us);
+  TEST_ASSERT_TRUE(Duration::fromMillis(2) > end - start);
+}
+
+static bool finished;
+
+// A countdown started 3 s before millis() would have wrapped, after the
+// clock has been up for ~49.7 days
+static void test_countdown_across_millis_wrap() {
+  ManualTime time(MILLIS_WRAP_US - 3000000);
+  MirroredDisplay display(13, 12);
+  CountdownTimer timer(display);
+  finished = false;
+  timer.setOnFinished([]() { finished = true; });
+  timer.setTime(10);
+  timer.start();
+
+  time.advanceMillis(5000);
+  timer.update();
+  TEST_ASSERT_EQUAL(5, timer.getRemainingTime());
+  TEST_ASSERT_FALSE(finished);
+
+  time.advanceMillis(4999);
+  timer.update();
+  TEST_ASSERT_FALSE(finished);
+
+  time.advanceMillis(1);
+  timer.update();
+  TEST_ASSERT_TRUE(finished);
+  TEST_ASSERT_FALSE(timer.isRunning());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_source_is_injectable);
+  RUN_TEST(test_deadline_across_old_wraps);
+  RUN_TEST(test_durations_keep_microseconds);
+  RUN_TEST(test_countdown_across_millis_wrap);
+  return UNITY_END();
+}
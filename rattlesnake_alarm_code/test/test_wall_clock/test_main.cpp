@@ -0,0 +1,176 @@
+#include <unity.h>
+#include <random>
+#include "WallClock.h"
+#include "ManualTime.h"
+
+// Host and device are simulated against one true timeline. The host clock
+// is the reference; the device's microsecond timer starts at an arbitrary
+// value and runs off by `ppm`. Each exchange has a random one-way USB delay.
+struct SkewedLink {
+  double ppm;
+  int64_t device_start;
+  int64_t host_start;
+  std::mt19937 rng;
+  std::uniform_int_distribution<int> delay_us;
+
+  SkewedLink(double ppm, int min_delay, int max_delay, unsigned seed = 1)
+    : ppm(ppm),
+      device_start(5000000),
+      host_start(43200LL * 1000000LL), // 12:00:00
+      rng(seed),
+      delay_us(min_delay, max_delay) {}
+
+  int64_t device(int64_t true_us) { return device_start + (int64_t)(true_us * (1.0 + ppm * 1e-6)); }
+  int64_t host(int64_t true_us) { return host_start + true_us; }
+
+  // One TIME_SYNC / TIME_SYNC_DONE round starting at true time `at`
+  bool exchange(WallClock& clock, int64_t at) {
+    int64_t out = delay_us(rng);
+    int64_t back = delay_us(rng);
+    const int64_t turnaround = 50;
+    int64_t t1 = host(at);
+    int64_t t2 = device(at + out);
+    int64_t t3 = device(at + out + turnaround);
+    int64_t t4 = host(at + out + turnaround + back);
+    return clock.addSample(t1, t2, t3, t4);
+  }
+};
+
+static const int64_t SECOND = 1000000;
+
+void setUp() {}
+void tearDown() {}
+
+static void checkConvergence(double ppm) {
+  // The jitter is random, so one lucky seed proves nothing
+  for (unsigned seed = 1; seed <= 16; seed++) {
+    SkewedLink link(ppm, 200, 3000, seed);
+    WallClock clock;
+    ManualTime time;
+
+    int64_t at = 0;
+    for (int i = 0; i < 40; i++) {
+      at += 10 * SECOND;
+      link.exchange(clock, at);
+    }
+    TEST_ASSERT_TRUE(clock.isSynced());
+    // Within 2 ppm of the true rate error after ~7 minutes of samples
+    TEST_ASSERT_INT32_WITHIN(2000, (int32_t)(ppm * 1000), clock.getDriftPpb());
+
+    // Free-running for an hour on the estimate alone
+    at += 3600 * SECOND;
+    time.now_us = link.device(at);
+    TEST_ASSERT_INT64_WITHIN(10000, link.host(at), clock.now());
+  }
+}
+
+void test_converges_on_fast_crystal() {
+  checkConvergence(85.0);
+}
+
+void test_converges_on_slow_crystal() {
+  checkConvergence(-40.0);
+}
+
+void test_host_clock_step_restarts_fit() {
+  SkewedLink link(50.0, 500, 500);
+  WallClock clock;
+  ManualTime time;
+
+  int64_t at = 0;
+  for (int i = 0; i < 10; i++) {
+    at += 10 * SECOND;
+    link.exchange(clock, at);
+  }
+  TEST_ASSERT_INT32_WITHIN(1000, 50000, clock.getDriftPpb());
+
+  // The host jumps an hour ahead (NTP, DST, a manual change). The new time
+  // is taken over, but the jump must not read as a 360000 ppm crystal.
+  link.host_start += 3600 * SECOND;
+  at += 10 * SECOND;
+  TEST_ASSERT_TRUE(link.exchange(clock, at));
+  TEST_ASSERT_INT32_WITHIN(1000, 50000, clock.getDriftPpb());
+  time.now_us = link.device(at + SECOND);
+  TEST_ASSERT_INT64_WITHIN(1000, link.host(at + SECOND), clock.now());
+
+  // Later samples rebuild the estimate from the new timeline
+  for (int i = 0; i < 10; i++) {
+    at += 10 * SECOND;
+    link.exchange(clock, at);
+  }
+  TEST_ASSERT_INT32_WITHIN(1000, 50000, clock.getDriftPpb());
+}
+
+void test_first_sample_sets_offset_without_drift() {
+  SkewedLink link(0, 1000, 1000);
+  WallClock clock;
+  ManualTime time;
+
+  TEST_ASSERT_FALSE(clock.isSynced());
+  TEST_ASSERT_TRUE(link.exchange(clock, 0));
+  TEST_ASSERT_EQUAL_INT32(0, clock.getDriftPpb());
+  time.now_us = link.device(10 * SECOND);
+  // Symmetric delays, so the midpoint estimate is exact
+  TEST_ASSERT_INT64_WITHIN(1, link.host(10 * SECOND), clock.now());
+}
+
+void test_rejects_slow_round_trip() {
+  SkewedLink link(20.0, 500, 500);
+  WallClock clock;
+  ManualTime time;
+
+  TEST_ASSERT_TRUE(link.exchange(clock, 0));
+  TEST_ASSERT_TRUE(link.exchange(clock, 10 * SECOND));
+
+  // 50ms each way, far beyond twice the best round trip
+  SkewedLink congested(20.0, 50000, 50000);
+  TEST_ASSERT_FALSE(congested.exchange(clock, 20 * SECOND));
+  TEST_ASSERT_EQUAL_UINT32(2, clock.getSampleCount());
+
+  // Replies that claim to leave before they arrive are nonsense
+  TEST_ASSERT_FALSE(clock.addSample(0, 2000, 1000, 5000));
+}
+
+void test_alarm_fires_once_time_is_crossed() {
+  SkewedLink link(0, 500, 500);
+  WallClock clock;
+  ManualTime time;
+
+  link.exchange(clock, 0);
+  clock.armAlarm(43200 + 5); // 12:00:05
+  time.now_us = link.device(4 * SECOND);
+  TEST_ASSERT_FALSE(clock.alarmDue());
+  time.now_us = link.device(6 * SECOND);
+  TEST_ASSERT_TRUE(clock.alarmDue());
+  // Latched until disarmed
+  time.now_us = link.device(60 * SECOND);
+  TEST_ASSERT_TRUE(clock.alarmDue());
+  clock.disarmAlarm();
+  TEST_ASSERT_FALSE(clock.alarmDue());
+}
+
+void test_alarm_across_midnight() {
+  SkewedLink link(0, 500, 500);
+  link.host_start = (86400LL - 10) * SECOND; // 23:59:50
+  WallClock clock;
+  ManualTime time;
+
+  link.exchange(clock, 0);
+  clock.armAlarm(3); // 00:00:03
+  time.now_us = link.device(5 * SECOND);
+  TEST_ASSERT_FALSE(clock.alarmDue());
+  time.now_us = link.device(15 * SECOND);
+  TEST_ASSERT_TRUE(clock.alarmDue());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_converges_on_fast_crystal);
+  RUN_TEST(test_converges_on_slow_crystal);
+  RUN_TEST(test_host_clock_step_restarts_fit);
+  RUN_TEST(test_first_sample_sets_offset_without_drift);
+  RUN_TEST(test_rejects_slow_round_trip);
+  RUN_TEST(test_alarm_fires_once_time_is_crossed);
+  RUN_TEST(test_alarm_across_midnight);
+  return UNITY_END();
+}
@@ -0,0 +1,218 @@
+#include "Device.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+static const char ECHO_PREFIX[] = "Received command: ";
+
+// A reply is over once the next echo arrives or the port has been quiet
+// this long; the firmware prints a whole reply within one loop() pass
+static const std::chrono::milliseconds QUIET_TIME(20);
+// Give up on a command the clock never acknowledged
+static const std::chrono::milliseconds ECHO_TIMEOUT(2000);
+
+Device::Device(const std::string& name, const std::string& path, const std::string& group)
+  : device_name(name),
+    device_path(path),
+    device_group(group),
+    port_fd(-1) {}
+
+Device::~Device() {
+  close();
+}
+
+bool Device::open() {
+  int fd = ::open(device_path.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+  if (fd < 0) {
+    return false;
+  }
+
+  struct termios tio;
+  if (tcgetattr(fd, &tio) == 0) {
+    cfmakeraw(&tio);
+    cfsetispeed(&tio, B115200);
+    cfsetospeed(&tio, B115200);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tcsetattr(fd, TCSANOW, &tio);
+  }
+
+  port_fd = fd;
+  rx_buffer.clear();
+  tx_buffer.clear();
+  return true;
+}
+
+void Device::close() {
+  if (port_fd >= 0) {
+    ::close(port_fd);
+    port_fd = -1;
+  }
+}
+
+bool Device::isOpen() const {
+  return port_fd >= 0;
+}
+
+int Device::fd() const {
+  return port_fd;
+}
+
+const std::string& Device::name() const {
+  return device_name;
+}
+
+const std::string& Device::path() const {
+  return device_path;
+}
+
+const std::string& Device::group() const {
+  return device_group;
+}
+
+void Device::queueCommand(const std::string& command, int request_id) {
+  waiting.push_back({ command, request_id, Clock::now(), false, {} });
+  fillTxBuffer();
+}
+
+bool Device::hasQueued(const std::string& command) const {
+  for (const Pending& p : waiting) {
+    if (p.command == command) {
+      return true;
+    }
+  }
+  for (const Pending& p : in_flight) {
+    if (p.command == command) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void Device::fillTxBuffer() {
+  while (!waiting.empty() && in_flight.size() < MAX_IN_FLIGHT) {
+    Pending p = std::move(waiting.front());
+    waiting.pop_front();
+    p.sent = Clock::now();
+    tx_buffer += p.command;
+    tx_buffer += '\n';
+    in_flight.push_back(std::move(p));
+  }
+}
+
+bool Device::wantsWrite() const {
+  return !tx_buffer.empty();
+}
+
+bool Device::flushWrites() {
+  while (!tx_buffer.empty()) {
+    ssize_t n = ::write(port_fd, tx_buffer.data(), tx_buffer.size());
+    if (n < 0) {
+      return errno == EAGAIN || errno == EINTR;
+    }
+    tx_buffer.erase(0, n);
+  }
+  return true;
+}
+
+bool Device::readAvailable(std::vector<Completion>& done) {
+  char buf[512];
+  for (;;) {
+    ssize_t n = ::read(port_fd, buf, sizeof(buf));
+    if (n < 0) {
+      if (errno == EAGAIN || errno == EINTR) {
+        break;
+      }
+      return false;
+    }
+    if (n == 0) {
+      return false;
+    }
+    last_rx = Clock::now();
+    rx_buffer.append(buf, n);
+  }
+
+  size_t start = 0;
+  for (;;) {
+    size_t end = rx_buffer.find_first_of("\r\n", start);
+    if (end == std::string::npos) {
+      break;
+    }
+    if (end > start) {
+      handleLine(rx_buffer.substr(start, end - start), done);
+    }
+    start = end + 1;
+  }
+  rx_buffer.erase(0, start);
+  return true;
+}
+
+void Device::handleLine(const std::string& line, std::vector<Completion>& done) {
+  if (line.compare(0, sizeof(ECHO_PREFIX) - 1, ECHO_PREFIX) == 0) {
+    std::string command = line.substr(sizeof(ECHO_PREFIX) - 1);
+
+    // The previous command's reply ends where the next echo starts
+    if (!in_flight.empty() && in_flight.front().echoed) {
+      complete(done, false);
+    }
+    if (!in_flight.empty() && in_flight.front().command == command) {
+      in_flight.front().echoed = true;
+    }
+    return;
+  }
+
+  if (!in_flight.empty() && in_flight.front().echoed) {
+    in_flight.front().lines.push_back(line);
+  }
+  // Anything else is unsolicited debug output from the firmware
+}
+
+void Device::complete(std::vector<Completion>& done, bool timed_out) {
+  Pending p = std::move(in_flight.front());
+  in_flight.pop_front();
+
+  if (!timed_out && p.command == "STATUS") {
+    status_cache.clear();
+    for (const std::string& line : p.lines) {
+      size_t colon = line.find(": ");
+      if (colon != std::string::npos) {
+        status_cache[line.substr(0, colon)] = line.substr(colon + 2);
+      }
+    }
+    status_time = Clock::now();
+  }
+
+  done.push_back({ p.request_id, device_name, p.command, std::move(p.lines), timed_out });
+  fillTxBuffer();
+}
+
+void Device::expire(Clock::time_point now, std::vector<Completion>& done) {
+  while (!in_flight.empty()) {
+    const Pending& front = in_flight.front();
+    if (front.echoed && now - last_rx >= QUIET_TIME) {
+      complete(done, false);
+    } else if (!front.echoed && now - front.sent >= ECHO_TIMEOUT) {
+      complete(done, true);
+    } else {
+      break;
+    }
+  }
+}
+
+void Device::failAll(std::vector<Completion>& done) {
+  fillTxBuffer();
+  while (!in_flight.empty()) {
+    complete(done, true);
+    fillTxBuffer();
+  }
+  tx_buffer.clear();
+}
+
+const std::map<std::string, std::string>& Device::status() const {
+  return status_cache;
+}
+
+Clock::time_point Device::statusTime() const {
+  return status_time;
+}
@@ -0,0 +1,79 @@
+#ifndef DEVICE_H
+#define DEVICE_H
+
+#include <chrono>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+// Reply to one command sent to one clock
+struct Completion {
+  int request_id;
+  std::string device;
+  std::string command;
+  std::vector<std::string> lines;
+  bool timed_out;
+};
+
+// One clock on a serial port. Commands are pipelined: up to MAX_IN_FLIGHT
+// are written ahead, and replies are matched to them through the
+// firmware's "Received command: X" echo that precedes every response.
+class Device {
+  public:
+    Device(const std::string& name, const std::string& path, const std::string& group);
+    ~Device();
+
+    bool open();
+    void close();
+    bool isOpen() const;
+    int fd() const;
+
+    const std::string& name() const;
+    const std::string& path() const;
+    const std::string& group() const;
+
+    void queueCommand(const std::string& command, int request_id);
+    bool hasQueued(const std::string& command) const;
+    bool wantsWrite() const;
+    bool flushWrites();
+    bool readAvailable(std::vector<Completion>& done);
+    void expire(Clock::time_point now, std::vector<Completion>& done);
+    void failAll(std::vector<Completion>& done);
+
+    const std::map<std::string, std::string>& status() const;
+    Clock::time_point statusTime() const;
+
+    static const size_t MAX_IN_FLIGHT = 8;
+
+  private:
+    struct Pending {
+      std::string command;
+      int request_id;
+      Clock::time_point sent;
+      bool echoed;
+      std::vector<std::string> lines;
+    };
+
+    std::string device_name;
+    std::string device_path;
+    std::string device_group;
+    int port_fd;
+
+    std::deque<Pending> waiting;   // not yet written
+    std::deque<Pending> in_flight; // written, oldest first
+    std::string tx_buffer;
+    std::string rx_buffer;
+    Clock::time_point last_rx;
+
+    std::map<std::string, std::string> status_cache;
+    Clock::time_point status_time;
+
+    void fillTxBuffer();
+    void handleLine(const std::string& line, std::vector<Completion>& done);
+    void complete(std::vector<Completion>& done, bool timed_out);
+};
+
+#endif
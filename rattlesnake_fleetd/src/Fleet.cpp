@@ -0,0 +1,424 @@
+#include "Fleet.h"
+
+#include <algorithm>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static const std::chrono::milliseconds RECONNECT_INTERVAL(2000);
+static const size_t MAX_CLIENT_LINE = 4096;
+
+Fleet::Fleet(const std::string& socket_path)
+  : socket_path(socket_path),
+    epoll_fd(-1),
+    listen_fd(-1),
+    status_interval(1000),
+    next_request_id(1) {}
+
+Fleet::~Fleet() {
+  for (auto& entry : clients) {
+    close(entry.first);
+  }
+  if (listen_fd >= 0) {
+    close(listen_fd);
+    unlink(socket_path.c_str());
+  }
+  if (epoll_fd >= 0) {
+    close(epoll_fd);
+  }
+}
+
+void Fleet::addDevice(const std::string& name, const std::string& path, const std::string& group) {
+  devices.emplace_back(new Device(name, path, group));
+}
+
+void Fleet::setStatusInterval(std::chrono::milliseconds interval) {
+  status_interval = interval;
+}
+
+bool Fleet::listen() {
+  listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (listen_fd < 0) {
+    perror("socket");
+    return false;
+  }
+
+  struct sockaddr_un addr = {};
+  addr.sun_family = AF_UNIX;
+  if (socket_path.size() >= sizeof(addr.sun_path)) {
+    fprintf(stderr, "Socket path too long: %s\n", socket_path.c_str());
+    return false;
+  }
+  socket_path.copy(addr.sun_path, sizeof(addr.sun_path) - 1);
+  unlink(socket_path.c_str());
+
+  if (bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || ::listen(listen_fd, 16) < 0) {
+    perror(socket_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+void Fleet::watch(int fd, bool want_write) {
+  struct epoll_event ev = {};
+  ev.events = want_write ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+  ev.data.fd = fd;
+  if (epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &ev) < 0 && errno == ENOENT) {
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+  }
+}
+
+void Fleet::unwatch(int fd) {
+  epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+}
+
+int Fleet::run(volatile bool& stop) {
+  epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  if (epoll_fd < 0 || !listen()) {
+    return 1;
+  }
+  watch(listen_fd, false);
+  reconnect(Clock::now());
+
+  std::vector<struct epoll_event> events(64 + devices.size());
+  std::vector<Completion> done;
+
+  while (!stop) {
+    // Short timeout while replies are outstanding so quiet-time completion
+    // stays prompt; otherwise just often enough for polling and reconnects
+    int timeout = requests.empty() ? 100 : 5;
+    int count = epoll_wait(epoll_fd, events.data(), events.size(), timeout);
+    if (count < 0 && errno != EINTR) {
+      perror("epoll_wait");
+      return 1;
+    }
+
+    for (int i = 0; i < count; i++) {
+      int fd = events[i].data.fd;
+      uint32_t mask = events[i].events;
+
+      if (fd == listen_fd) {
+        acceptClients();
+        continue;
+      }
+
+      auto device = device_by_fd.find(fd);
+      if (device != device_by_fd.end()) {
+        Device& d = *device->second;
+        bool ok = true;
+        if (mask & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+          ok = d.readAvailable(done);
+        }
+        if (ok && (mask & EPOLLOUT)) {
+          ok = d.flushWrites();
+        }
+        if (!ok) {
+          d.failAll(done);
+          dropDevice(d);
+        }
+        continue;
+      }
+
+      if (clients.count(fd) && (mask & EPOLLOUT)) {
+        writeClient(fd);
+      }
+      if (clients.count(fd) && (mask & (EPOLLIN | EPOLLHUP | EPOLLERR))) {
+        readClient(fd);
+      }
+    }
+
+    Clock::time_point now = Clock::now();
+    for (auto& d : devices) {
+      if (d->isOpen()) {
+        d->expire(now, done);
+      }
+    }
+    deliver(done);
+
+    pollStatus(now);
+    if (now - last_reconnect >= RECONNECT_INTERVAL) {
+      reconnect(now);
+    }
+
+    // Commands queued this pass go out without waiting for EPOLLOUT
+    for (auto& d : devices) {
+      if (d->isOpen() && d->wantsWrite()) {
+        if (!d->flushWrites()) {
+          d->failAll(done);
+          dropDevice(*d);
+          continue;
+        }
+        watch(d->fd(), d->wantsWrite());
+      } else if (d->isOpen()) {
+        watch(d->fd(), false);
+      }
+    }
+    deliver(done);
+  }
+  return 0;
+}
+
+void Fleet::reconnect(Clock::time_point now) {
+  last_reconnect = now;
+  for (auto& d : devices) {
+    if (!d->isOpen() && d->open()) {
+      device_by_fd[d->fd()] = d.get();
+      watch(d->fd(), false);
+      fprintf(stderr, "%s: connected on %s\n", d->name().c_str(), d->path().c_str());
+    }
+  }
+}
+
+void Fleet::dropDevice(Device& device) {
+  fprintf(stderr, "%s: disconnected\n", device.name().c_str());
+  unwatch(device.fd());
+  device_by_fd.erase(device.fd());
+  device.close();
+}
+
+// Keeps the cached STATUS of every clock fresh; request id 0 means nobody
+// is waiting for the reply
+void Fleet::pollStatus(Clock::time_point now) {
+  for (auto& d : devices) {
+    if (d->isOpen() && now - d->statusTime() >= status_interval && !d->hasQueued("STATUS")) {
+      d->queueCommand("STATUS", 0);
+    }
+  }
+}
+
+void Fleet::deliver(std::vector<Completion>& done) {
+  for (Completion& c : done) {
+    auto request = requests.find(c.request_id);
+    if (request == requests.end()) {
+      continue;
+    }
+
+    Request& r = request->second;
+    if (clients.count(r.client_fd)) {
+      std::string out;
+      if (c.timed_out) {
+        out = c.device + " TIMEOUT\n";
+      } else {
+        r.answered++;
+        if (c.lines.empty()) {
+          out = c.device + " OK\n";
+        }
+        for (const std::string& line : c.lines) {
+          out += c.device + " " + line + "\n";
+        }
+      }
+      send(r.client_fd, out);
+    }
+
+    if (--r.outstanding == 0) {
+      if (clients.count(r.client_fd)) {
+        send(r.client_fd, "DONE " + std::to_string(r.answered) + "\n");
+      }
+      requests.erase(request);
+    }
+  }
+  done.clear();
+}
+
+void Fleet::acceptClients() {
+  for (;;) {
+    int fd = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0) {
+      return;
+    }
+    clients[fd] = Client();
+    watch(fd, false);
+  }
+}
+
+void Fleet::readClient(int fd) {
+  Client& client = clients[fd];
+  char buf[1024];
+  for (;;) {
+    ssize_t n = read(fd, buf, sizeof(buf));
+    if (n > 0) {
+      client.rx.append(buf, n);
+      continue;
+    }
+    if (n == 0 || (errno != EAGAIN && errno != EINTR)) {
+      closeClient(fd);
+      return;
+    }
+    break;
+  }
+
+  size_t newline;
+  while (clients.count(fd) && (newline = clients[fd].rx.find('\n')) != std::string::npos) {
+    std::string line = clients[fd].rx.substr(0, newline);
+    clients[fd].rx.erase(0, newline + 1);
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+    handleRequest(fd, line);
+  }
+
+  if (clients.count(fd) && clients[fd].rx.size() > MAX_CLIENT_LINE) {
+    closeClient(fd);
+  }
+}
+
+void Fleet::send(int fd, const std::string& text) {
+  Client& client = clients[fd];
+  client.tx += text;
+  writeClient(fd);
+}
+
+void Fleet::writeClient(int fd) {
+  Client& client = clients[fd];
+  while (!client.tx.empty()) {
+    ssize_t n = write(fd, client.tx.data(), client.tx.size());
+    if (n < 0) {
+      if (errno == EAGAIN || errno == EINTR) {
+        break;
+      }
+      closeClient(fd);
+      return;
+    }
+    client.tx.erase(0, n);
+  }
+  watch(fd, !client.tx.empty());
+}
+
+void Fleet::closeClient(int fd) {
+  unwatch(fd);
+  close(fd);
+  clients.erase(fd);
+
+  // Replies still in flight for this client are dropped on arrival, even if
+  // a new client is handed the same descriptor
+  for (auto& entry : requests) {
+    if (entry.second.client_fd == fd) {
+      entry.second.client_fd = -1;
+    }
+  }
+}
+
+// Control socket protocol, one request per line:
+//   LIST
+//   STATUS <target>
+//   START <target> | STOP <target> | SET_TIME <target> <seconds>
+//   SEND <target> <raw command>
+// where <target> is a device name, a group name or "all". Replies are
+// "<device> <text>" lines followed by "DONE <n>", or a single "ERROR <why>".
+void Fleet::handleRequest(int fd, const std::string& line) {
+  size_t space = line.find(' ');
+  std::string verb = line.substr(0, space);
+  std::string rest = space == std::string::npos ? "" : line.substr(space + 1);
+  std::transform(verb.begin(), verb.end(), verb.begin(), ::toupper);
+
+  space = rest.find(' ');
+  std::string target = rest.substr(0, space);
+  std::string args = space == std::string::npos ? "" : rest.substr(space + 1);
+
+  if (verb == "LIST") {
+    listDevices(fd);
+  } else if (verb == "STATUS" && !target.empty()) {
+    reportStatus(fd, target);
+  } else if (verb == "START" && !target.empty()) {
+    broadcast(fd, target, "TIMER_START");
+  } else if (verb == "STOP" && !target.empty()) {
+    broadcast(fd, target, "TIMER_STOP");
+  } else if (verb == "SET_TIME" && !target.empty() && !args.empty()) {
+    broadcast(fd, target, "SET_TIME " + args);
+  } else if (verb == "SEND" && !target.empty() && !args.empty()) {
+    std::transform(args.begin(), args.end(), args.begin(), ::toupper);
+    broadcast(fd, target, args);
+  } else {
+    send(fd, "ERROR unknown request\n");
+  }
+}
+
+std::vector<Device*> Fleet::select(const std::string& target) {
+  std::vector<Device*> selected;
+  for (auto& d : devices) {
+    if (target == "all" || d->name() == target || d->group() == target) {
+      selected.push_back(d.get());
+    }
+  }
+  return selected;
+}
+
+void Fleet::broadcast(int fd, const std::string& target, const std::string& command) {
+  std::vector<Device*> selected = select(target);
+  if (selected.empty()) {
+    send(fd, "ERROR no such device or group\n");
+    return;
+  }
+
+  int id = next_request_id++;
+  if (next_request_id <= 0) {
+    next_request_id = 1;
+  }
+  Request request = { fd, 0, 0 };
+
+  std::string offline;
+  for (Device* d : selected) {
+    if (d->isOpen()) {
+      d->queueCommand(command, id);
+      request.outstanding++;
+    } else {
+      offline += d->name() + " OFFLINE\n";
+    }
+  }
+
+  if (!offline.empty()) {
+    send(fd, offline);
+  }
+  if (request.outstanding == 0) {
+    send(fd, "DONE 0\n");
+    return;
+  }
+  requests[id] = request;
+}
+
+void Fleet::reportStatus(int fd, const std::string& target) {
+  std::vector<Device*> selected = select(target);
+  if (selected.empty()) {
+    send(fd, "ERROR no such device or group\n");
+    return;
+  }
+
+  Clock::time_point now = Clock::now();
+  std::string out;
+  size_t reported = 0;
+  for (Device* d : selected) {
+    out += d->name();
+    if (!d->isOpen()) {
+      out += " OFFLINE\n";
+      continue;
+    }
+    if (d->status().empty()) {
+      out += " PENDING\n";
+      continue;
+    }
+    for (const auto& field : d->status()) {
+      std::string key = field.first;
+      std::replace(key.begin(), key.end(), ' ', '_');
+      out += " " + key + "=" + field.second;
+    }
+    long age = std::chrono::duration_cast<std::chrono::milliseconds>(now - d->statusTime()).count();
+    out += " Age_ms=" + std::to_string(age) + "\n";
+    reported++;
+  }
+  out += "DONE " + std::to_string(reported) + "\n";
+  send(fd, out);
+}
+
+void Fleet::listDevices(int fd) {
+  std::string out;
+  for (auto& d : devices) {
+    out += d->name() + " " + (d->group().empty() ? "-" : d->group()) + " " + d->path() + " "
+      + (d->isOpen() ? "connected" : "disconnected") + "\n";
+  }
+  out += "DONE " + std::to_string(devices.size()) + "\n";
+  send(fd, out);
+}
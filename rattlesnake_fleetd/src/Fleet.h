@@ -0,0 +1,66 @@
+#ifndef FLEET_H
+#define FLEET_H
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Device.h"
+
+// Single-threaded epoll loop serving every clock's serial port and the
+// clients of the local control socket.
+class Fleet {
+  public:
+    explicit Fleet(const std::string& socket_path);
+    ~Fleet();
+
+    void addDevice(const std::string& name, const std::string& path, const std::string& group);
+    void setStatusInterval(std::chrono::milliseconds interval);
+    int run(volatile bool& stop);
+
+  private:
+    struct Client {
+      std::string rx;
+      std::string tx;
+    };
+
+    struct Request {
+      int client_fd;
+      size_t outstanding;
+      size_t answered;
+    };
+
+    std::string socket_path;
+    int epoll_fd;
+    int listen_fd;
+    std::chrono::milliseconds status_interval;
+    std::vector<std::unique_ptr<Device>> devices;
+    std::map<int, Device*> device_by_fd;
+    std::map<int, Client> clients;
+    std::map<int, Request> requests;
+    int next_request_id;
+    Clock::time_point last_reconnect;
+
+    bool listen();
+    void watch(int fd, bool want_write);
+    void unwatch(int fd);
+
+    void reconnect(Clock::time_point now);
+    void pollStatus(Clock::time_point now);
+    void dropDevice(Device& device);
+    void deliver(std::vector<Completion>& done);
+
+    void acceptClients();
+    void readClient(int fd);
+    void writeClient(int fd);
+    void closeClient(int fd);
+    void send(int fd, const std::string& text);
+    void handleRequest(int fd, const std::string& line);
+    void broadcast(int fd, const std::string& target, const std::string& command);
+    void reportStatus(int fd, const std::string& target);
+    void listDevices(int fd);
+    std::vector<Device*> select(const std::string& target);
+};
+
+#endif
@@ -0,0 +1,72 @@
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Fleet.h"
+
+static volatile bool stopRequested = false;
+
+static void onSignal(int) {
+  stopRequested = true;
+}
+
+static void usage(const char* argv0) {
+  fprintf(stderr,
+    "Usage: %s [--socket PATH] [--status-interval MS] NAME=PORT[@GROUP]...\n"
+    "\n"
+    "Example:\n"
+    "  %s --socket /tmp/rattlesnake.sock \\\n"
+    "     bench1=/dev/ttyACM0@stationA bench2=/dev/ttyACM1@stationA\n",
+    argv0, argv0);
+}
+
+int main(int argc, char** argv) {
+  std::string socket_path = "/tmp/rattlesnake_fleetd.sock";
+  long status_interval = 1000;
+  std::vector<std::string> specs;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+      socket_path = argv[++i];
+    } else if (strcmp(argv[i], "--status-interval") == 0 && i + 1 < argc) {
+      status_interval = atol(argv[++i]);
+    } else if (strcmp(argv[i], "--help") == 0 || argv[i][0] == '-') {
+      usage(argv[0]);
+      return 2;
+    } else {
+      specs.push_back(argv[i]);
+    }
+  }
+
+  if (specs.empty() || status_interval <= 0) {
+    usage(argv[0]);
+    return 2;
+  }
+
+  Fleet fleet(socket_path);
+  fleet.setStatusInterval(std::chrono::milliseconds(status_interval));
+
+  for (const std::string& spec : specs) {
+    size_t equals = spec.find('=');
+    if (equals == std::string::npos || equals == 0) {
+      fprintf(stderr, "Bad device spec: %s\n", spec.c_str());
+      return 2;
+    }
+    std::string name = spec.substr(0, equals);
+    std::string port = spec.substr(equals + 1);
+    std::string group;
+    size_t at = port.rfind('@');
+    if (at != std::string::npos) {
+      group = port.substr(at + 1);
+      port = port.substr(0, at);
+    }
+    fleet.addDevice(name, port, group);
+  }
+
+  signal(SIGPIPE, SIG_IGN);
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+
+  return fleet.run(stopRequested);
+}
@@ -0,0 +1,331 @@
+// End-to-end test of rattlesnake_fleetd against simulated clocks.
+//
+// Every clock is a pseudo-terminal whose master side is served by a small
+// emulation of the firmware's serial protocol. The daemon is started on the
+// slave ports, driven through its control socket, and the latency of each
+// broadcast is measured.
+//
+//   fleet_sim_test DAEMON [--clocks N] [--rounds N] [--max-latency MS]
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+// One simulated clock. Replies mimic SerialCommands: an echo of the command
+// followed by its response, CRLF terminated.
+struct SimClock {
+  int master_fd;
+  int slave_fd; // held open so the master never sees a hangup
+  std::string slave_path;
+  std::string rx;
+  bool running;
+  long remaining;
+};
+
+static std::string respond(SimClock& clock, const std::string& command) {
+  std::string out = "Received command: " + command + "\r\n";
+  if (command == "STATUS") {
+    out += "Timer running: " + std::to_string(clock.running) + "\r\n";
+    out += "Remaining time: " + std::to_string(clock.remaining) + "\r\n";
+    out += "Alarm active: 0\r\nMotor started: 0\r\n";
+    out += std::string("State: ") + (clock.running ? "RUNNING" : "IDLE") + "\r\n";
+    out += "Transitions: 0\r\n";
+  } else if (command == "TIMER_START") {
+    clock.running = true;
+    out += "Timer started via serial command\r\n";
+  } else if (command == "TIMER_STOP") {
+    clock.running = false;
+    out += "Timer reset via serial command\r\n";
+  } else if (command.compare(0, 9, "SET_TIME ") == 0) {
+    clock.remaining = atol(command.c_str() + 9);
+    out += "Timer set to " + std::to_string(clock.remaining) + " seconds\r\n";
+  } else {
+    out += "Unknown command. Available commands:\r\n";
+  }
+  return out;
+}
+
+static bool openClock(SimClock& clock) {
+  clock.master_fd = posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC);
+  if (clock.master_fd < 0 || grantpt(clock.master_fd) < 0 || unlockpt(clock.master_fd) < 0) {
+    return false;
+  }
+  clock.slave_path = ptsname(clock.master_fd);
+  clock.slave_fd = open(clock.slave_path.c_str(), O_RDWR | O_NOCTTY | O_CLOEXEC);
+  if (clock.slave_fd < 0) {
+    return false;
+  }
+  struct termios tio;
+  tcgetattr(clock.slave_fd, &tio);
+  cfmakeraw(&tio);
+  tcsetattr(clock.slave_fd, TCSANOW, &tio);
+  clock.running = false;
+  clock.remaining = 10;
+  return true;
+}
+
+static void serveClocks(std::vector<SimClock>& clocks, std::atomic<bool>& stop) {
+  std::vector<struct pollfd> fds(clocks.size());
+  for (size_t i = 0; i < clocks.size(); i++) {
+    fds[i].fd = clocks[i].master_fd;
+    fds[i].events = POLLIN;
+  }
+
+  while (!stop) {
+    if (poll(fds.data(), fds.size(), 50) <= 0) {
+      continue;
+    }
+    for (size_t i = 0; i < clocks.size(); i++) {
+      if (!(fds[i].revents & POLLIN)) {
+        continue;
+      }
+      SimClock& clock = clocks[i];
+      char buf[512];
+      ssize_t n = read(clock.master_fd, buf, sizeof(buf));
+      if (n <= 0) {
+        continue;
+      }
+      clock.rx.append(buf, n);
+
+      size_t newline;
+      while ((newline = clock.rx.find('\n')) != std::string::npos) {
+        std::string command = clock.rx.substr(0, newline);
+        clock.rx.erase(0, newline + 1);
+        std::string reply = respond(clock, command);
+        if (write(clock.master_fd, reply.data(), reply.size()) < 0) {
+          perror("write");
+        }
+      }
+    }
+  }
+}
+
+static int connectSocket(const std::string& path) {
+  struct sockaddr_un addr = {};
+  addr.sun_family = AF_UNIX;
+  path.copy(addr.sun_path, sizeof(addr.sun_path) - 1);
+
+  Clock::time_point give_up = Clock::now() + std::chrono::seconds(5);
+  while (Clock::now() < give_up) {
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) == 0) {
+      return fd;
+    }
+    close(fd);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  return -1;
+}
+
+// Sends one control request and collects reply lines up to the closing
+// "DONE <n>" or "ERROR ..." line
+struct Reply {
+  std::vector<std::string> lines;
+  long done;
+  double ms;
+};
+
+static Reply request(int fd, const std::string& line) {
+  Reply reply = { {}, -1, 0 };
+  Clock::time_point start = Clock::now();
+  std::string text = line + "\n";
+  if (write(fd, text.data(), text.size()) < 0) {
+    return reply;
+  }
+
+  std::string rx;
+  for (;;) {
+    size_t newline;
+    while ((newline = rx.find('\n')) != std::string::npos) {
+      std::string l = rx.substr(0, newline);
+      rx.erase(0, newline + 1);
+      if (l.compare(0, 5, "DONE ") == 0) {
+        reply.done = atol(l.c_str() + 5);
+        reply.ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        return reply;
+      }
+      reply.lines.push_back(l);
+      if (l.compare(0, 6, "ERROR ") == 0) {
+        return reply;
+      }
+    }
+
+    struct pollfd p = { fd, POLLIN, 0 };
+    char buf[4096];
+    if (poll(&p, 1, 5000) <= 0) {
+      return reply;
+    }
+    ssize_t n = read(fd, buf, sizeof(buf));
+    if (n <= 0) {
+      return reply;
+    }
+    rx.append(buf, n);
+  }
+}
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+  printf("%s: %s\n", ok ? "PASS" : "FAIL", what);
+  if (!ok) {
+    failures++;
+  }
+}
+
+static size_t countLines(const Reply& reply, const std::string& suffix) {
+  size_t count = 0;
+  for (const std::string& l : reply.lines) {
+    if (l.size() >= suffix.size() && l.compare(l.size() - suffix.size(), suffix.size(), suffix) == 0) {
+      count++;
+    }
+  }
+  return count;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    fprintf(stderr, "Usage: %s DAEMON [--clocks N] [--rounds N] [--max-latency MS]\n", argv[0]);
+    return 2;
+  }
+  const char* daemon = argv[1];
+  size_t clock_count = 200;
+  int rounds = 20;
+  double max_latency = 250;
+  for (int i = 2; i + 1 < argc; i += 2) {
+    if (strcmp(argv[i], "--clocks") == 0) {
+      clock_count = atol(argv[i + 1]);
+    } else if (strcmp(argv[i], "--rounds") == 0) {
+      rounds = atoi(argv[i + 1]);
+    } else if (strcmp(argv[i], "--max-latency") == 0) {
+      max_latency = atof(argv[i + 1]);
+    }
+  }
+  if (clock_count < 2 || rounds < 1) {
+    fprintf(stderr, "Need at least 2 clocks and 1 round\n");
+    return 2;
+  }
+
+  std::vector<SimClock> clocks(clock_count);
+  for (SimClock& clock : clocks) {
+    if (!openClock(clock)) {
+      perror("pseudo-terminal");
+      return 1;
+    }
+  }
+
+  std::atomic<bool> stop(false);
+  std::thread simulator(serveClocks, std::ref(clocks), std::ref(stop));
+
+  // Even clocks are in group A, odd ones in group B
+  std::string socket_path = "/tmp/fleet_sim_test." + std::to_string(getpid()) + ".sock";
+  std::vector<std::string> args = { daemon, "--socket", socket_path, "--status-interval", "100" };
+  for (size_t i = 0; i < clocks.size(); i++) {
+    args.push_back("c" + std::to_string(i) + "=" + clocks[i].slave_path + (i % 2 ? "@B" : "@A"));
+  }
+
+  pid_t pid = fork();
+  if (pid == 0) {
+    // Silence the per-clock "connected" lines
+    int null_fd = open("/dev/null", O_WRONLY);
+    dup2(null_fd, STDERR_FILENO);
+    std::vector<char*> argv_exec;
+    for (std::string& a : args) {
+      argv_exec.push_back(&a[0]);
+    }
+    argv_exec.push_back(nullptr);
+    execv(daemon, argv_exec.data());
+    _exit(127);
+  }
+
+  int fd = connectSocket(socket_path);
+  check(fd >= 0, "control socket accepts connections");
+  if (fd >= 0) {
+    const long all = clock_count;
+    const long group_a = (clock_count + 1) / 2;
+
+    Reply list = request(fd, "LIST");
+    check(list.done == all && countLines(list, " connected") == clock_count, "LIST shows every clock connected");
+
+    Reply set = request(fd, "SET_TIME A 90");
+    printf("SET_TIME to %ld clocks: %.1f ms\n", group_a, set.ms);
+    check(set.done == group_a && countLines(set, " Timer set to 90 seconds") == (size_t)group_a,
+      "SET_TIME reaches every clock in the group");
+    check(set.ms < max_latency, "SET_TIME latency within bound");
+
+    Reply start = request(fd, "START all");
+    printf("TIMER_START to %ld clocks: %.1f ms\n", all, start.ms);
+    check(start.done == all, "START is answered by every clock");
+    check(start.ms < max_latency, "START latency within bound");
+
+    // Wait for a background poll that saw the new state
+    Reply status;
+    size_t fresh = 0;
+    Clock::time_point give_up = Clock::now() + std::chrono::seconds(5);
+    while (fresh < (size_t)group_a && Clock::now() < give_up) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+      status = request(fd, "STATUS A");
+      fresh = 0;
+      for (const std::string& l : status.lines) {
+        if (l.find("Remaining_time=90") != std::string::npos && l.find("State=RUNNING") != std::string::npos) {
+          fresh++;
+        }
+      }
+    }
+    printf("Cached STATUS of %ld clocks: %.1f ms\n", group_a, status.ms);
+    check(status.done == group_a && fresh == (size_t)group_a, "cached STATUS reflects the broadcasts");
+
+    Reply unknown = request(fd, "BOGUS");
+    check(unknown.done < 0 && unknown.lines.size() == 1 && unknown.lines[0] == "ERROR unknown request",
+      "malformed request gets an error");
+
+    // Sustained broadcasts: every round hits all clocks
+    double worst = 0;
+    long answered = 0;
+    Clock::time_point t0 = Clock::now();
+    for (int r = 0; r < rounds; r++) {
+      Reply reply = request(fd, r % 2 ? "START all" : "STOP all");
+      answered += reply.done > 0 ? reply.done : 0;
+      if (reply.ms > worst) {
+        worst = reply.ms;
+      }
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - t0).count();
+    printf("%d broadcasts to %ld clocks: %.0f commands/s, worst %.1f ms\n",
+      rounds, all, answered / seconds, worst);
+    check(answered == all * rounds, "every broadcast is answered by every clock");
+    check(worst < max_latency, "broadcast latency within bound");
+
+    close(fd);
+  }
+
+  kill(pid, SIGTERM);
+  int wstatus = 0;
+  waitpid(pid, &wstatus, 0);
+  check(WIFEXITED(wstatus) && WEXITSTATUS(wstatus) == 0, "daemon exits cleanly on SIGTERM");
+
+  stop = true;
+  simulator.join();
+  for (SimClock& clock : clocks) {
+    close(clock.slave_fd);
+    close(clock.master_fd);
+  }
+
+  printf("%d failure(s)\n", failures);
+  return failures ? 1 : 0;
+}